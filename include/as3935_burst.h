@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================
+// AS3935-Auslesen mit einem I2C-Burst
+// =============================
+// Die Lib braucht pro Blitz fünf Transaktionen (readInterruptReg, distanceToStorm und drei für
+// lightningEnergy). Der AS3935 erhöht die Registeradresse beim Lesen selbst, also holt der
+// Sensor-Task 0x03..0x07 in einem Zug und zerlegt hier den Puffer:
+//   0x03 [3:0] INT     Interruptquelle
+//   0x04       S_LIG_L Energie, Bits 7:0
+//   0x05       S_LIG_M Energie, Bits 15:8
+//   0x06 [4:0] S_LIG_MM Energie, Bits 20:16
+//   0x07 [5:0] DISTANCE km (63 = außer Reichweite)
+// Die Nachlesung ohne Interrupt beginnt bei 0x04 (ohne INT, das Register bleibt unberührt).
+
+static constexpr uint8_t AS3935_REG_INT = 0x03;
+static constexpr uint8_t AS3935_REG_ENERGY = 0x04;
+static constexpr uint8_t AS3935_BURST_LEN = 5;  // 0x03..0x07
+static constexpr uint8_t AS3935_POLL_LEN = 4;   // 0x04..0x07
+
+struct As3935Reading {
+  uint8_t intSrc;
+  uint8_t distance;
+  uint32_t energy;
+};
+
+// buf[0] = 0x04 … buf[3] = 0x07
+inline void decodeAs3935Measurement(const uint8_t* buf, As3935Reading& r) {
+  r.energy = (uint32_t)(buf[2] & 0x1F) << 16 | (uint32_t)buf[1] << 8 | buf[0];
+  r.distance = buf[3] & 0x3F;
+}
+
+// buf[0] = 0x03 … buf[4] = 0x07
+inline As3935Reading decodeAs3935Burst(const uint8_t* buf) {
+  As3935Reading r;
+  r.intSrc = buf[0] & 0x0F;
+  decodeAs3935Measurement(buf + 1, r);
+  return r;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "interference.h"
+
+// =============================
+// Laufzeit-Konfiguration (/api/config, gespeichert im NVS)
+// =============================
+// Alles, was sich pro Standort unterscheidet, ohne neu zu flashen: Analogteil des AS3935,
+// Eventmaske, Größe der History, Reset-Zeit der Live-Werte und die Nachlesung nach einem
+// Blitz. Die Vorgaben kommen aus main.cpp (AFE_BASE, EVENT_MASK, …).
+// CONFIG_FIELDS beschreibt jedes Feld einmal: Schlüssel (zugleich NVS-Key, daher ≤ 15 Zeichen),
+// Grenzen und Zugriff. JSON-Ausgabe, Parser, Prüfung und NVS laufen alle über diese Tabelle.
+
+struct DeviceConfig {
+  bool indoor;          // AFE-Verstärkung: true = Indoor, false = Outdoor
+  AfeSettings afe;      // Ausgangswerte der Nachführung (interference.h)
+  uint8_t eventMask;    // Interruptquellen, die gespeichert werden (0b1000 = Blitz)
+  uint32_t historyMax;  // Einträge in der History, höchstens deren Kapazität
+  uint32_t resetSec;    // ohne Blitz so lange → Live-Werte zurücksetzen
+  uint32_t pollMs;      // Distanz so lange nach dem letzten Blitz nachlesen
+};
+
+static constexpr uint8_t CONFIG_EVENT_BITS = INT_NOISE | INT_DISTURBER | INT_LIGHTNING;
+static constexpr uint32_t CONFIG_HISTORY_MIN = 16;
+
+struct ConfigField {
+  const char* key;
+  uint32_t min;
+  uint32_t max;       // 0 = Kapazität der History (siehe validateConfig)
+  bool isBool;
+  uint32_t (*get)(const DeviceConfig&);
+  void (*set)(DeviceConfig&, uint32_t);
+};
+
+static constexpr ConfigField CONFIG_FIELDS[] = {
+  {"indoor", 0, 1, true,
+   [](const DeviceConfig& c) -> uint32_t { return c.indoor; },
+   [](DeviceConfig& c, uint32_t v) { c.indoor = v != 0; }},
+  {"noise_level", 1, 7, false,
+   [](const DeviceConfig& c) -> uint32_t { return c.afe.noiseLevel; },
+   [](DeviceConfig& c, uint32_t v) { c.afe.noiseLevel = (uint8_t)v; }},
+  {"watchdog", 1, 10, false,
+   [](const DeviceConfig& c) -> uint32_t { return c.afe.watchdog; },
+   [](DeviceConfig& c, uint32_t v) { c.afe.watchdog = (uint8_t)v; }},
+  {"spike_rejection", 1, 11, false,
+   [](const DeviceConfig& c) -> uint32_t { return c.afe.spike; },
+   [](DeviceConfig& c, uint32_t v) { c.afe.spike = (uint8_t)v; }},
+  {"mask_disturber", 0, 1, true,
+   [](const DeviceConfig& c) -> uint32_t { return c.afe.maskDisturber; },
+   [](DeviceConfig& c, uint32_t v) { c.afe.maskDisturber = v != 0; }},
+  {"event_mask", 1, CONFIG_EVENT_BITS, false,
+   [](const DeviceConfig& c) -> uint32_t { return c.eventMask; },
+   [](DeviceConfig& c, uint32_t v) { c.eventMask = (uint8_t)v; }},
+  {"history_max", CONFIG_HISTORY_MIN, 0, false,
+   [](const DeviceConfig& c) -> uint32_t { return c.historyMax; },
+   [](DeviceConfig& c, uint32_t v) { c.historyMax = v; }},
+  {"reset_timeout_s", 10, 24 * 3600, false,
+   [](const DeviceConfig& c) -> uint32_t { return c.resetSec; },
+   [](DeviceConfig& c, uint32_t v) { c.resetSec = v; }},
+  {"poll_ms", 1000, 600000, false,
+   [](const DeviceConfig& c) -> uint32_t { return c.pollMs; },
+   [](DeviceConfig& c, uint32_t v) { c.pollMs = v; }},
+};
+static constexpr size_t CONFIG_FIELD_COUNT = sizeof(CONFIG_FIELDS) / sizeof(CONFIG_FIELDS[0]);
+static_assert(CONFIG_FIELD_COUNT <= 32, "configDiff: ein Bit pro Feld");
+
+constexpr uint32_t configFieldMax(const ConfigField& f, size_t historyCapacity) {
+  return f.max ? f.max : (uint32_t)historyCapacity;
+}
+
+// nullptr = gültig, sonst der Schlüssel des ersten ungültigen Felds
+constexpr const char* validateConfig(const DeviceConfig& c, size_t historyCapacity) {
+  for (const ConfigField& f : CONFIG_FIELDS) {
+    const uint32_t v = f.get(c);
+    if (v < f.min || v > configFieldMax(f, historyCapacity)) return f.key;
+  }
+  if (c.eventMask & ~CONFIG_EVENT_BITS) return "event_mask"; // 0b0010 gibt es nicht
+  return nullptr;
+}
+
+// Bit i gesetzt = CONFIG_FIELDS[i] unterscheidet sich
+inline uint32_t configDiff(const DeviceConfig& a, const DeviceConfig& b) {
+  uint32_t d = 0;
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; ++i) {
+    if (CONFIG_FIELDS[i].get(a) != CONFIG_FIELDS[i].get(b)) d |= 1u << i;
+  }
+  return d;
+}
+
+inline const ConfigField* findConfigField(const char* key) {
+  for (const ConfigField& f : CONFIG_FIELDS) {
+    const char* a = f.key;
+    const char* b = key;
+    while (*a && *a == *b) { ++a; ++b; }
+    if (!*a && !*b) return &f;
+  }
+  return nullptr;
+}
+
+// =============================
+// Registerabbild des AS3935-Analogteils
+// =============================
+// Die Setter der SparkFun-Lib lesen und schreiben je ein Register (Read-Modify-Write), auch
+// wenn sich nichts ändert; Noise-Level und Watchdog liegen sogar im selben Register. Stattdessen
+// führt der Sensor-Task ein Abbild der Register 0x00..0x03, rechnet daraus die Zielwerte und
+// schreibt nur die Bytes, die sich unterscheiden (meist eines, ohne vorheriges Lesen).
+//   0x00 [5:1] AFE_GB (Indoor 0b10010, Outdoor 0b01110), [0] PWD
+//   0x01 [6:4] NF_LEV, [3:0] WDTH
+//   0x02 [6] CL_STAT, [5:4] MIN_NUM_LIGH, [3:0] SREJ
+//   0x03 [7:6] LCO_FDIV, [5] MASK_DIST, [3:0] INT (nur lesbar, im Abbild 0)
+static constexpr size_t AFE_REG_COUNT = 4;
+static constexpr uint8_t AFE_GB_INDOOR = 0x12;
+static constexpr uint8_t AFE_GB_OUTDOOR = 0x0E;
+
+struct AfeRegisters {
+  uint8_t reg[AFE_REG_COUNT];
+};
+
+// Abbild aus den gelesenen Registern (INT-Bits verwerfen)
+inline AfeRegisters afeRegistersFrom(const uint8_t raw[AFE_REG_COUNT]) {
+  AfeRegisters r;
+  for (size_t i = 0; i < AFE_REG_COUNT; ++i) r.reg[i] = raw[i];
+  r.reg[3] &= 0xF0;
+  return r;
+}
+
+// Zielwerte: nur die Felder aus indoor/afe ändern, alle übrigen Bits bleiben
+inline AfeRegisters afeRegisterImage(const AfeRegisters& cur, bool indoor, const AfeSettings& a) {
+  AfeRegisters r = cur;
+  r.reg[0] = (uint8_t)((r.reg[0] & ~0x3E) | (indoor ? AFE_GB_INDOOR : AFE_GB_OUTDOOR) << 1);
+  r.reg[1] = (uint8_t)((r.reg[1] & 0x80) | (a.noiseLevel & 0x07) << 4 | (a.watchdog & 0x0F));
+  r.reg[2] = (uint8_t)((r.reg[2] & 0xF0) | (a.spike & 0x0F));
+  r.reg[3] = (uint8_t)((r.reg[3] & 0xD0) | (a.maskDisturber ? 0x20 : 0));
+  return r;
+}
+
+// Registerprüfung des Supervisors: nur 0x00..0x02. Lesen von 0x03 löscht die INT-Bits und gibt
+// den IRQ-Pin frei – ein gerade anstehender Blitz ginge dem Sensor-Task verloren. MASK_DIST
+// (0x03) bleibt deshalb ungeprüft.
+static constexpr size_t AFE_CHECK_COUNT = 3;
+
+inline bool afeRegistersMatch(const AfeRegisters& img, const uint8_t raw[AFE_CHECK_COUNT]) {
+  for (size_t i = 0; i < AFE_CHECK_COUNT; ++i) {
+    if (img.reg[i] != raw[i]) return false;
+  }
+  return true;
+}
+
+// Bit i gesetzt = Register i muss geschrieben werden
+inline uint8_t afeRegistersChanged(const AfeRegisters& a, const AfeRegisters& b) {
+  uint8_t m = 0;
+  for (size_t i = 0; i < AFE_REG_COUNT; ++i) {
+    if (a.reg[i] != b.reg[i]) m |= 1u << i;
+  }
+  return m;
+}
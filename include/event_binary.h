@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "event_store.h"
+
+// =============================
+// Binärexport für /api/events.bin
+// =============================
+// Kein JSON, keine Stringformatierung pro Zeile: die gepackten 8-Byte-Einträge gehen so, wie
+// sie im Speicher liegen, hinter einem kleinen versionierten Header raus. Alle Felder
+// little-endian. Format (Version 2), siehe auch readme.md:
+//
+//   Offset Größe  Feld
+//   0      4      Magic "LTNG"
+//   4      1      Version (2; 1 = dt in Sekunden)
+//   5      1      Größe eines Eintrags in Byte (8)
+//   6      2      Größe des Headers in Byte (24)
+//   8      4      seq des ersten Eintrags (folgende Einträge: seq+1, seq+2, …)
+//   12     4      head_seq (neueste seq im Gerät zum Zeitpunkt der Anfrage)
+//   16     8      Basiszeit (int64, Unix-Sekunden)
+//   24     8*n    Einträge, älteste zuerst:
+//                   uint32 dt   : Millisekunden, ts = Basiszeit + dt / 1000
+//                   uint32 bits : [5:0] Distanz km, [26:6] Energie, [30:27] Interruptquelle, [31] irq
+//
+// Die Anzahl der Einträge ergibt sich aus der Länge: n = (Länge - 24) / 8.
+
+static constexpr uint8_t EVENT_BIN_VERSION = 2;
+static constexpr size_t EVENT_BIN_HEADER_SIZE = 24;
+
+inline void putLe16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+inline void putLe32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+inline void putLe64(uint8_t* p, uint64_t v) { putLe32(p, (uint32_t)v); putLe32(p + 4, (uint32_t)(v >> 32)); }
+
+// Zeitbereich wie bei /api/events (EventQuery: since/from/to/after/limit), aber immer aufsteigend
+// und lückenlos – Wertefilter und order gelten hier nicht, sonst wäre seq nicht mehr aus
+// first_seq ableitbar. Wird ein Eintrag während der Übertragung getrimmt oder folgt eine Lücke
+// in den Sequenznummern (Neustart, siehe EventStore::skipTo), endet der Export dort – die
+// gelieferten Einträge bleiben über first_seq eindeutig zuordenbar, der Rest kommt mit after=.
+template <typename Store>
+class EventBinaryStream {
+public:
+  EventBinaryStream(const Store& store, const EventQuery& q)
+    : store_(store), base_(store.base()) {
+    store.queryRange(q, next_, end_);
+    if (q.limit && end_ - next_ > q.limit) end_ = next_ + q.limit;
+
+    uint8_t* h = pending_;
+    memcpy(h, "LTNG", 4);
+    h[4] = EVENT_BIN_VERSION;
+    h[5] = sizeof(PackedEvent);
+    putLe16(h + 6, EVENT_BIN_HEADER_SIZE);
+    nextSeq_ = store.seqOf(next_);
+    putLe32(h + 8, nextSeq_);
+    putLe32(h + 12, store.headSeq());
+    putLe64(h + 16, (uint64_t)(int64_t)base_);
+    pendingLen_ = EVENT_BIN_HEADER_SIZE;
+  }
+
+  size_t read(char* out, size_t max) {
+    size_t written = 0;
+    while (written < max) {
+      if (pendingOff_ == pendingLen_ && !refill()) break;
+      size_t n = pendingLen_ - pendingOff_;
+      if (n > max - written) n = max - written;
+      memcpy(out + written, pending_ + pendingOff_, n);
+      pendingOff_ += n;
+      written += n;
+    }
+    return written;
+  }
+
+private:
+  bool refill() {
+    pendingOff_ = pendingLen_ = 0;
+    if (next_ == end_ || !store_.validPos(next_) || store_.base() != base_) return false;
+    if (store_.seqOf(next_) != nextSeq_++) return false;
+    const PackedEvent& p = store_.rawAtPos(next_++);
+    putLe32(pending_, p.dt);
+    putLe32(pending_ + 4, p.bits);
+    pendingLen_ = sizeof(PackedEvent);
+    return true;
+  }
+
+  const Store& store_;
+  time_t base_;
+  uint32_t next_;
+  uint32_t end_;
+  uint32_t nextSeq_;
+  uint8_t pending_[EVENT_BIN_HEADER_SIZE];
+  size_t pendingLen_ = 0;
+  size_t pendingOff_ = 0;
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+// =============================
+// Ereigniszeit aus monotoner Zeit + NTP-Offset
+// =============================
+// Zeitstempel werden im ISR als esp_timer_get_time() (µs seit Boot, 64 Bit, monoton) genommen.
+// Die Wanduhr steckt nur im Offset: Unix-µs = mono + offset. Jede NTP-Synchronisation setzt den
+// Offset neu; ein Sprung der Systemuhr verschiebt damit keine bereits genommenen Zeitstempel,
+// und stamp() läuft nie rückwärts (korrigiert NTP nach hinten, bleiben die Zeitstempel stehen,
+// bis die Uhr wieder aufgeholt hat).
+// Vor der ersten Synchronisation liefern stamp()/now() µs seit Boot (< UNIX_VALID_MIN_US).
+
+static constexpr int64_t US_PER_SEC = 1000000;
+
+class EventClock {
+public:
+  static constexpr int64_t UNIX_VALID_MIN_US = 1600000000LL * US_PER_SEC;
+
+  // Referenz: zum Zeitpunkt monoUs war es unixUs
+  void sync(int64_t unixUs, int64_t monoUs) {
+    const int64_t off = unixUs - monoUs;
+    if (synced_) lastStepUs_ = off - offsetUs_;
+    offsetUs_ = off;
+    synced_ = true;
+    syncs_++;
+  }
+
+  bool synced() const { return synced_; }
+  int64_t offsetUs() const { return offsetUs_; }
+  int64_t lastStepUs() const { return lastStepUs_; } // Korrektur der letzten Synchronisation
+  uint32_t syncs() const { return syncs_; }
+
+  // Zeitstempel für ein Ereignis (in Aufrufreihenfolge nie fallend)
+  int64_t stamp(int64_t monoUs) {
+    int64_t t = now(monoUs);
+    if (t < lastStampUs_) t = lastStampUs_;
+    lastStampUs_ = t;
+    return t;
+  }
+
+  // Aktuelle Zeit ohne Monotonie-Klammer (Abfragen, Fenstergrenzen)
+  int64_t now(int64_t monoUs) const { return synced_ ? monoUs + offsetUs_ : monoUs; }
+
+  static bool isUnix(int64_t us) { return us >= UNIX_VALID_MIN_US; }
+
+private:
+  int64_t offsetUs_ = 0;
+  int64_t lastStepUs_ = 0;
+  int64_t lastStampUs_ = 0;
+  uint32_t syncs_ = 0;
+  bool synced_ = false;
+};
+
+// µs → Sekunden + Millisekunden (abgerundet, auch für negative Werte)
+inline time_t usToSec(int64_t us) { return (time_t)(us >= 0 ? us / US_PER_SEC : -((-us + US_PER_SEC - 1) / US_PER_SEC)); }
+inline uint16_t usToMs(int64_t us) { return (uint16_t)((us - (int64_t)usToSec(us) * US_PER_SEC) / 1000); }
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "event_store.h"
+
+// =============================
+// JSON-Streaming für /api/events
+// =============================
+// Kein JsonDocument, kein String: jede Zeile wird direkt aus dem Ereignisspeicher in einen
+// kleinen Zeilenpuffer formatiert und stückweise abgeholt. Der Speicherbedarf pro Anfrage
+// ist damit konstant, egal wie viele Ereignisse im Speicher liegen.
+
+inline size_t formatIso8601(char* buf, size_t len, time_t t) {
+  struct tm timeinfo;
+  gmtime_r(&t, &timeinfo);
+  return strftime(buf, len, "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
+}
+
+// Ein Ereignis als JSON-Objekt; liefert die Länge oder 0, wenn buf zu klein ist
+inline size_t formatEventJson(char* buf, size_t len, const LightningEvent& e, uint32_t seq) {
+  char iso[32];
+  formatIso8601(iso, sizeof(iso), e.ts);
+  int n = snprintf(buf, len,
+                   "{\"seq\":%lu,\"ts\":%lld,\"ts_ms\":%lld,\"iso\":\"%s\",\"distance_km\":%u,\"energy\":%lu,\"event\":%lu,\"irq\":%s}",
+                   (unsigned long)seq, (long long)e.ts, (long long)e.ts * 1000 + e.ms, iso, (unsigned)e.distance, (unsigned long)e.energy,
+                   (unsigned long)e.event, e.irq ? "true" : "false");
+  return (n > 0 && (size_t)n < len) ? (size_t)n : 0;
+}
+
+// Liefert {"head_seq":N,"events":[...],"more":bool}.
+// - ohne after: alle Ereignisse im Zeitbereich, neuestes zuerst
+// - mit after : Ereignisse mit seq > after, ältestes zuerst; bei more=true mit after=<letzte seq>
+//               weiterblättern
+// order (EventQuery) dreht die Reihenfolge explizit. Der Zeitbereich wird beim Start per binärer
+// Suche auf Positionen abgebildet, es wird nur innerhalb [lo, hi) gelaufen; Wertefilter laufen
+// auf den gepackten Einträgen, entpackt und formatiert werden nur Treffer.
+// read() füllt out mit so viel Text wie passt und gibt 0 zurück, wenn alles geliefert ist.
+// Der Cursor ist eine absolute Position: Zwischen zwei read()-Aufrufen darf der Speicher
+// wachsen oder getrimmt werden (AsyncWebServer), bereits entfernte Einträge werden übersprungen.
+template <typename Store>
+class EventJsonStream {
+public:
+  EventJsonStream(const Store& store, const EventQuery& q)
+    : store_(store), q_(q), headSeq_(store.headSeq()), asc_(q.ascending()) {
+    store.queryRange(q, lo_, hi_);
+    next_ = asc_ ? lo_ : hi_;
+  }
+
+  size_t read(char* out, size_t max) {
+    size_t written = 0;
+    while (written < max) {
+      if (pendingOff_ == pendingLen_ && !refill()) break;
+      size_t n = pendingLen_ - pendingOff_;
+      if (n > max - written) n = max - written;
+      memcpy(out + written, pending_ + pendingOff_, n);
+      pendingOff_ += n;
+      written += n;
+    }
+    return written;
+  }
+
+private:
+  enum Phase : uint8_t { HEAD, ROWS, TAIL, DONE };
+
+  // Nächste passende Position oder false, wenn die Auswahl erschöpft ist
+  bool nextPos(uint32_t& pos) {
+    if (asc_) {
+      if ((int32_t)(store_.beginPos() - next_) > 0) next_ = store_.beginPos(); // inzwischen getrimmt
+      while ((int32_t)(hi_ - next_) > 0 && store_.validPos(next_)) {
+        const uint32_t p = next_++;
+        if (q_.matches(store_.rawAtPos(p))) { pos = p; return true; }
+      }
+      return false;
+    }
+    while ((int32_t)(next_ - lo_) > 0 && store_.validPos(next_ - 1)) {
+      const uint32_t p = --next_;
+      if (q_.matches(store_.rawAtPos(p))) { pos = p; return true; }
+    }
+    return false;
+  }
+
+  bool refill() {
+    pendingOff_ = pendingLen_ = 0;
+    switch (phase_) {
+      case HEAD:
+        pendingLen_ = snprintf(pending_, sizeof(pending_), "{\"head_seq\":%lu,\"events\":[", (unsigned long)headSeq_);
+        phase_ = ROWS;
+        return true;
+      case ROWS: {
+        uint32_t pos;
+        if (q_.limit && count_ >= q_.limit) {
+          more_ = nextPos(pos);
+        } else if (nextPos(pos)) {
+          size_t off = 0;
+          if (count_) pending_[off++] = ',';
+          count_++;
+          pendingLen_ = off + formatEventJson(pending_ + off, sizeof(pending_) - off,
+                                              store_.atPos(pos), store_.seqOf(pos));
+          return true;
+        }
+        phase_ = TAIL;
+      }
+        // fall through
+      case TAIL:
+        pendingLen_ = snprintf(pending_, sizeof(pending_), "],\"more\":%s}", more_ ? "true" : "false");
+        phase_ = DONE;
+        return true;
+      case DONE:
+      default:
+        return false;
+    }
+  }
+
+  const Store& store_;
+  EventQuery q_;
+  uint32_t headSeq_;
+  bool asc_;
+  uint32_t lo_, hi_;   // Zeitbereich als Positionen [lo, hi), beim Start der Anfrage bestimmt
+  uint32_t next_;      // nächste Position (aufsteigend ab lo_, sonst rückwärts ab hi_)
+  uint32_t count_ = 0;
+  bool more_ = false;
+  Phase phase_ = HEAD;
+  char pending_[160];  // eine formatierte Zeile
+  size_t pendingLen_ = 0;
+  size_t pendingOff_ = 0;
+};
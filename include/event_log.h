@@ -0,0 +1,122 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "event_store.h"
+
+// =============================
+// Persistente History (Append-Log auf LittleFS)
+// =============================
+// Ereignisse werden im RAM gesammelt und blockweise an Segmentdateien /ev/sXXXXXXXX
+// angehängt. LittleFS verteilt die Schreibzugriffe selbst über den Flash (Wear-Leveling),
+// wir schreiben nie an eine bestehende Stelle zurück: volle Segmente werden nur noch gelesen
+// und als Ganzes gelöscht, wenn sie aus dem Aufbewahrungsfenster fallen.
+//
+// Segment = 32 Byte Header + n gepackte Einträge (8 Byte, dt in ms relativ zur Segment-Basis;
+// Segmente der Version 1 mit dt in Sekunden werden weiter gelesen, aber nicht fortgeschrieben).
+// Beim Booten werden nur die Header gelesen, um die Segmente der letzten 24h zu finden;
+// danach werden genau diese Einträge blockweise eingelesen.
+//
+// Write-behind: append() legt Einträge nur in einer RAM-Staging-Seite ab (kurze kritische
+// Sektion, nie Flash). Ein Schreib-Task niedriger Priorität tauscht die volle Seite gegen die
+// leere und schreibt sie weg, während bereits in die andere Seite gesammelt wird. Erase/Program
+// des Flash (mehrere ms CPU-Stillstand) fallen damit nie in loop() oder den Sensor-Task.
+//
+//   Offset Größe  Feld
+//   0      4      Magic "LSEG"
+//   4      1      Version (2, 1 = dt in Sekunden)
+//   5      1      Größe eines Eintrags (8)
+//   6      2      Größe des Headers (32)
+//   8      4      Segmentnummer
+//   12     4      seq des ersten Eintrags (folgende fortlaufend)
+//   16     8      Basiszeit (int64, Unix-Sekunden, = ts des ersten Eintrags)
+//   24     8      reserviert
+
+class EventLog {
+public:
+  static constexpr uint32_t SEG_RECORDS = 512;   // 4 KB Nutzdaten pro Segment (= 1 Flash-Block)
+  static constexpr uint32_t MAX_SEGMENTS = 18;   // ≥ HISTORY_MAX / SEG_RECORDS + Reserve
+  static constexpr size_t BATCH_MAX = 64;        // Einträge pro Staging-Seite
+  static constexpr size_t HEADER_SIZE = 32;
+  static constexpr size_t STAGING_MAX = 2 * BATCH_MAX; // nie mehr Einträge nur im RAM
+
+  // Callback für replay(): Ereignis + seq, in aufsteigender Reihenfolge
+  typedef void (*ReplayFn)(const LightningEvent& e, uint32_t seq, void* ctx);
+
+  // Liest die Segment-Header; false, wenn das Dateisystem nicht nutzbar ist
+  bool begin(fs::FS& fs);
+
+  // Spielt die Einträge der letzten windowSec Sekunden (relativ zum neuesten) zurück
+  size_t replay(time_t windowSec, ReplayFn fn, void* ctx);
+
+  // Startet den Schreib-Task: geschrieben wird, sobald batch Einträge gesammelt sind
+  // (max. BATCH_MAX), spätestens aber intervalMs nach dem letzten Schreibvorgang
+  bool startWriter(size_t batch, uint32_t intervalMs, UBaseType_t prio, uint32_t stack = 4096);
+
+  // Ereignis in die Staging-Seite legen; blockiert nie und fasst den Flash nicht an.
+  // Ist die Seite voll, weil der Flash nicht nachkommt, wird das Ereignis verworfen (dropped()).
+  void append(const LightningEvent& e, uint32_t seq);
+
+  // Alles Gesammelte sofort schreiben (Schreib-Task, Shutdown-Handler); wartet bis waitMs auf
+  // einen laufenden Schreibvorgang. false bei Schreibfehler oder Zeitüberschreitung, die
+  // Einträge bleiben dann vorgemerkt.
+  bool flush(uint32_t waitMs = 2000);
+
+  // seq hinter dem neuesten geschriebenen Eintrag (aus den Segment-Headern), 0 = leeres Log.
+  // Vergeben sein können auch die STAGING_MAX Nummern danach (vor einem Reset nicht geschrieben).
+  uint32_t nextSeq() const;
+
+  size_t pending() const;
+  uint32_t lastFlushMs() const { return lastFlushMs_; }
+  uint32_t segmentCount() const { return segCount_; }
+  uint32_t writeErrors() const { return writeErrors_; }
+  uint32_t dropped() const { return dropped_; }
+
+private:
+  struct SegInfo {
+    uint32_t no;
+    uint32_t firstSeq;
+    int64_t base;
+    uint32_t records;
+    uint8_t version;
+  };
+  struct Item {
+    int64_t tsMs;   // Unix-Millisekunden
+    uint32_t bits;
+    uint32_t seq;
+  };
+
+  struct Page {
+    Item items[BATCH_MAX];
+    size_t len;
+  };
+
+  static void writerTask(void* arg);
+  bool writeSpare();
+  size_t writeItems(const Item* items, size_t n);
+  bool readHeader(const char* path, SegInfo& out);
+  bool openNewSegment(const Item& first);
+  void dropOldest();
+  static void segPath(char* buf, size_t len, uint32_t no);
+
+  fs::FS* fs_ = nullptr;
+  SegInfo segs_[MAX_SEGMENTS];   // aufsteigend nach Segmentnummer
+  uint32_t segCount_ = 0;
+  bool curWritable_ = false;     // letztes Segment darf fortgeschrieben werden
+
+  // pages_[active_] nimmt append() auf (unter lock_), die andere Seite gehört dem Schreiber
+  // (unter ioMutex_). Getauscht wird nur, wenn beide gehalten werden.
+  Page pages_[2] = {};
+  uint8_t active_ = 0;
+  mutable portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED;
+  StaticSemaphore_t ioMutexBuf_;
+  SemaphoreHandle_t ioMutex_ = nullptr;
+  TaskHandle_t task_ = nullptr;
+  size_t flushBatch_ = BATCH_MAX;
+  uint32_t flushIntervalMs_ = 60000;
+
+  volatile uint32_t lastFlushMs_ = 0;
+  uint32_t writeErrors_ = 0;
+  volatile uint32_t dropped_ = 0;
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "event_store.h"
+#include "event_clock.h"
+#include "ring_buffer.h"
+#include "stats_aggregate.h"
+
+// =============================
+// Ereignis-Pipeline in loop(): Messung übernehmen → History, Statistik, Live-Werte
+// =============================
+// Derselbe Code läuft auf dem Gerät (main.cpp) und im Host-Test (test_pipeline). Was am Gerät
+// hängt, kommt über die Hooks-Klasse H:
+//   H::Lock          RAII-Sperre für History, Statistik und Samples (main.cpp: HistoryLock)
+//   H::LiveLock      RAII-Sperre für die Live-Werte (main.cpp: liveMux)
+//   recorded(e, seq) nach dem Eintrag in die History: Log, Stream-Clients, Peers
+//   restamp(e)       Boot-Zeitstempel über e.monoUs auf Unix-Zeit umrechnen
+// Aufgerufen wird nur aus loop(); setLastEvent() auch aus dem Sensor-Task.
+
+// Zuletzt gemeldete Werte für /api/live und MQTT. Ein Schnappschuss sieht Distanz, Energie und
+// Zeit desselben Blitzes.
+struct LiveState {
+  uint8_t distance = 63;  // zuletzt gemeldete Distanz (km)
+  uint32_t energy = 0;    // zuletzt gemeldete Energie (keine physikalische Bedeutung)
+  time_t eventTs = 0;     // erst gesetzt, wenn der Blitz in die History geht
+  uint8_t event = 0;      // REG0x03 des letzten Interrupts, 0 nach einer Nachlesung
+  bool irq = false;       // letzte Messung per Interrupt (sonst Polling)
+};
+
+template <size_t N, size_t SAMPLES, typename H>
+class EventPipeline {
+public:
+  // Blitze vor der ersten NTP-Synchronisation (Zeit = Sekunden seit Boot), max. 64, danach
+  // fallen die ältesten
+  static constexpr size_t UNSYNCED_MAX = 64;
+
+  EventPipeline(EventStore<N>& history, MinuteAggregates& stats,
+                RingBuffer<DistanceSample, SAMPLES>& samples, H& hooks)
+    : history_(history), stats_(stats), samples_(samples), hooks_(hooks) {}
+
+  // Neues Ereignis in History und Statistik aufnehmen und weitermelden; liefert die seq
+  uint32_t record(const LightningEvent& e) {
+    uint32_t seq;
+    {
+      typename H::Lock lock;
+      history_.push_back(e);
+      seq = history_.headSeq();
+      stats_.add(e.ts, e.distance, e.energy);
+    }
+    hooks_.recorded(e, seq);
+    return seq;
+  }
+
+  // Vom Sensor-Task gelieferte Messung übernehmen. Nachlesungen (irq = false) gehen nur in
+  // Live-Werte und Samples; Interrupts aus eventMask in die History – vor der ersten
+  // Synchronisation erst zwischengespeichert (flushUnsynced).
+  void handle(LightningEvent ev, uint32_t eventMask, uint32_t nowMs) {
+    if (synced_ && !EventClock::isUnix((int64_t)ev.ts * US_PER_SEC)) hooks_.restamp(ev); // vor der Sync. gestempelt
+
+    if (!ev.irq) {
+      {
+        typename H::LiveLock lock;
+        live_.irq = false;
+        live_.distance = ev.distance;
+        live_.energy = ev.energy;
+        live_.event = 0;
+      }
+      typename H::Lock lock;
+      samples_.push_back(DistanceSample{ev.ts, ev.distance, ev.energy});
+      return;
+    }
+
+    const bool recorded = ev.event & eventMask;
+    {
+      typename H::LiveLock lock;
+      live_.irq = true;
+      if (recorded) {
+        live_.distance = ev.distance;
+        live_.energy = ev.energy;
+        if (synced_) live_.eventTs = ev.ts;
+      }
+    }
+    if (!recorded) return;
+    lastEventMs_ = nowMs;
+    if (!synced_) {
+      unsynced_.push_back(ev);
+      return;
+    }
+    record(ev);
+  }
+
+  // Nach der ersten Synchronisation: zurückgehaltene Blitze und Samples auf Unix-Zeit
+  // verschieben (sampleOffset = Unix-Zeit - Zeit seit Boot) und nachtragen. Liefert die Anzahl.
+  size_t flushUnsynced(time_t sampleOffset) {
+    {
+      typename H::Lock lock;
+      for (DistanceSample& s : samples_) {
+        if (!EventClock::isUnix((int64_t)s.ts * US_PER_SEC)) s.ts += sampleOffset;
+      }
+    }
+    const size_t n = unsynced_.size();
+    for (LightningEvent& e : unsynced_) {
+      hooks_.restamp(e);
+      {
+        typename H::LiveLock lock;
+        live_.eventTs = e.ts;
+      }
+      record(e);
+    }
+    unsynced_.clear();
+    synced_ = true;
+    return n;
+  }
+
+  // Uhr schon beim Start gültig (Softreset): Zeitstempel sind sofort Unix-Zeit
+  void markSynced() { synced_ = true; }
+  bool synced() const { return synced_; }
+
+  // Einträge älter als cutoff und über maxSize entfernen, abgelaufene Minuten austragen
+  void trim(time_t now, time_t cutoff, size_t maxSize) {
+    typename H::Lock lock;
+    while (!history_.empty() && history_.tsAt(0) < cutoff) history_.pop_front();
+    while (history_.size() > maxSize) history_.pop_front();
+    stats_.advance(now);
+  }
+
+  // timeoutMs nach dem letzten Blitz die Live-Werte zurücksetzen
+  void expireLive(uint32_t nowMs, uint32_t timeoutMs) {
+    if (nowMs - lastEventMs_ <= timeoutMs) return;
+    {
+      typename H::LiveLock lock;
+      live_.distance = 63;
+      live_.energy = 0;
+      live_.eventTs = 0;
+    }
+    lastEventMs_ = nowMs;
+  }
+
+  // Interruptquelle direkt nach dem Lesen (Sensor-Task), auch für nicht gespeicherte Störer
+  void setLastEvent(uint8_t src) {
+    typename H::LiveLock lock;
+    live_.event = src;
+  }
+
+  LiveState live() const {
+    typename H::LiveLock lock;
+    return live_;
+  }
+
+private:
+  EventStore<N>& history_;
+  MinuteAggregates& stats_;
+  RingBuffer<DistanceSample, SAMPLES>& samples_;
+  H& hooks_;
+  RingBuffer<LightningEvent, UNSYNCED_MAX> unsynced_;
+  LiveState live_;
+  uint32_t lastEventMs_ = 0;
+  bool synced_ = false; // ab hier werden Boot-Zeitstempel direkt verschoben
+};
+
+#ifdef CONTENT_LENGTH_UNKNOWN
+// Synchroner Zweig von sendStream() (nur mit WebServer.h, vorher einbinden): Header, dann
+// Chunks aus dem Stream, zum Schluss der leere Chunk. Die Sperre L gilt nur während read(),
+// nicht während des Sendens.
+template <typename L, typename Server, typename S>
+void sendStreamChunked(Server& srv, const char* type, S& stream) {
+  char chunk[512];
+  srv.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  srv.send(200, type, "");
+  size_t n;
+  for (;;) {
+    {
+      L lock;
+      n = stream.read(chunk, sizeof(chunk));
+    }
+    if (n == 0) break;
+    srv.sendContent(chunk, n);
+  }
+  srv.sendContent(""); // letzter (leerer) Chunk
+}
+#endif
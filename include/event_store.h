@@ -0,0 +1,264 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "ring_buffer.h"
+
+// =============================
+// Ereignis (entpackt)
+// =============================
+struct LightningEvent {
+  time_t ts;        // Unix Timestamp (UTC)
+  uint8_t distance; // 1..63 km (63 = out of range laut Datenblatt), 0 = Sturm sehr nahe / über Kopf
+  uint32_t energy;  // „Energy“ Rohwert aus dem Sensor (nicht kalibriert)
+  uint32_t event;
+  bool irq;
+  uint16_t ms = 0;    // Millisekunden zu ts (0..999)
+  int64_t monoUs = 0; // esp_timer_get_time() im ISR, µs seit Boot; nicht gespeichert
+};
+
+// Nachgelesene Distanzschätzung (Polling), kein eigener Blitz – eigene kleine Reihe, nie in der
+// History oder der Statistik
+struct DistanceSample {
+  time_t ts;
+  uint8_t distance;
+  uint32_t energy;
+};
+
+// =============================
+// Gepacktes Speicherformat (8 Byte statt 24 Byte)
+// =============================
+// dt   : Millisekunden seit EventStore-Basis (uint32 → reicht ~49 Tage, siehe EventStore)
+// bits : [5:0] Distanz (REG0x07[5:0]), [26:6] Energie (21 Bit, REG0x04..0x06),
+//        [30:27] Interruptquelle (REG0x03[3:0]), [31] irq
+struct PackedEvent {
+  uint32_t dt;
+  uint32_t bits;
+};
+static_assert(sizeof(PackedEvent) == 8, "PackedEvent muss 8 Byte gross sein");
+
+static constexpr uint32_t PACK_DIST_BITS   = 6;
+static constexpr uint32_t PACK_ENERGY_BITS = 21;
+static constexpr uint32_t PACK_EVENT_BITS  = 4;
+
+static constexpr uint32_t PACK_DIST_SHIFT   = 0;
+static constexpr uint32_t PACK_ENERGY_SHIFT = PACK_DIST_SHIFT + PACK_DIST_BITS;
+static constexpr uint32_t PACK_EVENT_SHIFT  = PACK_ENERGY_SHIFT + PACK_ENERGY_BITS;
+static constexpr uint32_t PACK_IRQ_SHIFT    = PACK_EVENT_SHIFT + PACK_EVENT_BITS;
+
+static constexpr uint32_t PACK_DIST_MASK   = (1u << PACK_DIST_BITS) - 1;
+static constexpr uint32_t PACK_ENERGY_MASK = (1u << PACK_ENERGY_BITS) - 1;
+static constexpr uint32_t PACK_EVENT_MASK  = (1u << PACK_EVENT_BITS) - 1;
+
+inline uint8_t packedDistance(const PackedEvent& p) { return (p.bits >> PACK_DIST_SHIFT) & PACK_DIST_MASK; }
+inline uint32_t packedEnergy(const PackedEvent& p) { return (p.bits >> PACK_ENERGY_SHIFT) & PACK_ENERGY_MASK; }
+inline uint8_t packedEventSrc(const PackedEvent& p) { return (p.bits >> PACK_EVENT_SHIFT) & PACK_EVENT_MASK; }
+inline bool packedIrq(const PackedEvent& p) { return (p.bits >> PACK_IRQ_SHIFT) & 1u; }
+
+static constexpr int64_t PACK_DT_MAX_MS = UINT32_MAX;
+
+// Zeitstempel in ms relativ zu einer Basis in Sekunden
+inline int64_t eventMsSince(const LightningEvent& e, time_t base) {
+  return (int64_t)(e.ts - base) * 1000 + e.ms;
+}
+
+// Werte außerhalb des Bitbereichs werden gesättigt (Distanz → 63, Energie → 2^21-1).
+// Zeitstempel vor der Basis werden auf die Basis geklemmt, damit die Liste sortiert bleibt.
+inline PackedEvent packEvent(const LightningEvent& e, time_t base) {
+  PackedEvent p;
+  const int64_t dt = eventMsSince(e, base);
+  p.dt = dt <= 0 ? 0 : dt > PACK_DT_MAX_MS ? (uint32_t)PACK_DT_MAX_MS : (uint32_t)dt;
+  uint32_t dist = e.distance > PACK_DIST_MASK ? PACK_DIST_MASK : e.distance;
+  uint32_t energy = e.energy > PACK_ENERGY_MASK ? PACK_ENERGY_MASK : e.energy;
+  p.bits = (dist << PACK_DIST_SHIFT)
+         | (energy << PACK_ENERGY_SHIFT)
+         | ((e.event & PACK_EVENT_MASK) << PACK_EVENT_SHIFT)
+         | ((e.irq ? 1u : 0u) << PACK_IRQ_SHIFT);
+  return p;
+}
+
+inline LightningEvent unpackEvent(const PackedEvent& p, time_t base) {
+  LightningEvent e;
+  e.ts = base + (time_t)(p.dt / 1000);
+  e.ms = (uint16_t)(p.dt % 1000);
+  e.distance = packedDistance(p);
+  e.energy = packedEnergy(p);
+  e.event = packedEventSrc(p);
+  e.irq = packedIrq(p);
+  return e;
+}
+
+// Auswahl für /api/events und /api/events.bin. Der Zeitbereich (cutoff/until/after) wird per
+// binärer Suche in Positionen übersetzt (queryRange), die Wertefilter prüft matches() direkt
+// auf den gepackten Bits, ohne Einträge zu entpacken.
+struct EventQuery {
+  time_t cutoff = 0;      // nur Einträge mit ts >= cutoff
+  time_t until = 0;       // nur Einträge mit ts <= until, 0 = offen
+  bool hasAfter = false;  // Delta-Modus: nur seq > afterSeq, älteste zuerst
+  uint32_t afterSeq = 0;
+  uint32_t limit = 0;     // max. Anzahl Einträge, 0 = alle
+  uint8_t minKm = 0;      // Distanz minKm..maxKm (63 = out of range)
+  uint8_t maxKm = PACK_DIST_MASK;
+  uint32_t minEnergy = 0;
+  uint8_t eventMask = 0;  // Interruptquelle & eventMask != 0, 0 = alle
+  int8_t order = 0;       // 1 = aufsteigend, -1 = absteigend, 0 = Standard (Delta-Modus aufsteigend)
+
+  bool ascending() const { return order ? order > 0 : hasAfter; }
+
+  bool filtersValues() const {
+    return minKm > 0 || maxKm < PACK_DIST_MASK || minEnergy > 0 || eventMask;
+  }
+
+  bool matches(const PackedEvent& p) const {
+    const uint8_t km = packedDistance(p);
+    return km >= minKm && km <= maxKm && packedEnergy(p) >= minEnergy
+        && (!eventMask || (packedEventSrc(p) & eventMask));
+  }
+};
+
+// =============================
+// Ereignisspeicher
+// =============================
+// Ringpuffer über gepackte Einträge. Die Basis wird beim ersten Eintrag in einen leeren
+// Speicher gesetzt; Lesezugriffe liefern entpackte LightningEvent-Werte (Index 0 = ältester).
+// Läge ein neuer Eintrag mehr als PACK_DT_MAX_MS hinter der Basis (der Speicher war ~49 Tage
+// nie leer), wird die Basis auf den ältesten Eintrag nachgezogen (einmalig O(N)); Einträge, die
+// selbst mehr als ~49 Tage vor dem neuen liegen, fallen dabei heraus.
+template <size_t N>
+class EventStore {
+public:
+  static constexpr size_t capacity() { return N; }
+  size_t size() const { return ring_.size(); }
+  bool empty() const { return ring_.empty(); }
+  void clear() { ring_.clear(); dropPassedGaps(); }
+
+  void push_back(const LightningEvent& e) {
+    while (!ring_.empty() && eventMsSince(e, base_) > PACK_DT_MAX_MS) {
+      rebase();
+      if (eventMsSince(e, base_) > PACK_DT_MAX_MS) ring_.pop_front();
+    }
+    if (ring_.empty()) base_ = e.ts;
+    ring_.push_back(packEvent(e, base_));
+    if (gapCount_) dropPassedGaps();
+  }
+  void pop_front() { ring_.pop_front(); if (gapCount_) dropPassedGaps(); }
+
+  LightningEvent operator[](size_t i) const { return unpackEvent(ring_[i], base_); }
+  LightningEvent front() const { return unpackEvent(ring_.front(), base_); }
+  LightningEvent back() const { return unpackEvent(ring_.back(), base_); }
+
+  // Nur Zeitstempel, ohne den Rest zu entpacken
+  time_t tsAt(size_t i) const { return base_ + (time_t)(ring_[i].dt / 1000); }
+
+  const PackedEvent& raw(size_t i) const { return ring_[i]; }
+
+  // Zugriff über absolute Position (siehe RingBuffer::beginPos/endPos)
+  uint32_t beginPos() const { return ring_.beginPos(); }
+  uint32_t endPos() const { return ring_.endPos(); }
+  bool validPos(uint32_t p) const { return ring_.validPos(p); }
+  LightningEvent atPos(uint32_t p) const { return unpackEvent(ring_.atPos(p), base_); }
+  const PackedEvent& rawAtPos(uint32_t p) const { return ring_.atPos(p); }
+  time_t tsAtPos(uint32_t p) const { return base_ + (time_t)(ring_.atPos(p).dt / 1000); }
+
+  // Sequenznummer = absolute Position + 1 + Versatz (0 = „noch kein Eintrag“). Steigt monoton und
+  // bleibt für einen Eintrag gleich, auch wenn ältere Einträge herausfallen → Cursor für
+  // Delta-Abfragen. Der Versatz wächst nur an Lücken (skipTo): Nummern, die vor einem Neustart
+  // schon vergeben sein können oder deren Einträge im Log fehlen, werden nie neu vergeben.
+  uint32_t seqOf(uint32_t pos) const { return pos + 1 + offsetAt(pos); }
+  uint32_t headSeq() const { return ring_.endPos() + headOffset(); }
+
+  // Erste Position mit seqOf(pos) > seq, endPos() wenn es keine gibt (Lücken werden übersprungen)
+  uint32_t posAfter(uint32_t seq) const {
+    uint32_t from = ring_.beginPos(), off = offset_;
+    for (uint8_t i = 0; i <= gapCount_; ++i) {
+      const uint32_t to = i < gapCount_ ? gaps_[i].pos : ring_.endPos();
+      const uint32_t p = seq - off; // in [from, to) gilt seqOf(p) = seq + 1
+      if ((int32_t)(p - to) < 0) return (int32_t)(p - from) > 0 ? p : from;
+      if (i < gapCount_) { from = to; off = gaps_[i].offset; }
+    }
+    return ring_.endPos();
+  }
+
+  // Leert den Speicher; der nächste Eintrag bekommt die Sequenznummer nextSeq
+  void restartAt(uint32_t nextSeq) {
+    ring_.resetPos(nextSeq - 1);
+    offset_ = 0;
+    gapCount_ = 0;
+  }
+
+  // Der nächste Eintrag bekommt mindestens die Sequenznummer nextSeq. Vorhandene Einträge
+  // behalten ihre Nummern, dazwischen bleibt eine Lücke. Sind schon MAX_SEQ_GAPS Lücken im
+  // Speicher, fallen die Einträge vor der ältesten heraus.
+  void skipTo(uint32_t nextSeq) {
+    const uint32_t off = nextSeq - 1 - ring_.endPos();
+    if ((int32_t)(off - headOffset()) <= 0) return;
+    if (gapCount_ == MAX_SEQ_GAPS) {
+      while ((int32_t)(gaps_[0].pos - ring_.beginPos()) > 0) ring_.pop_front();
+      dropPassedGaps();
+    }
+    if (ring_.empty()) offset_ = off;
+    else if (gapCount_ && gaps_[gapCount_ - 1].pos == ring_.endPos()) gaps_[gapCount_ - 1].offset = off;
+    else gaps_[gapCount_++] = SeqGap{ring_.endPos(), off};
+  }
+
+  // Erste Position mit ts >= t (binäre Suche; die Liste ist zeitlich sortiert, siehe packEvent)
+  uint32_t lowerBoundTs(time_t t) const {
+    uint32_t lo = ring_.beginPos(), n = ring_.endPos() - lo;
+    while (n > 0) {
+      const uint32_t half = n / 2;
+      if (tsAtPos(lo + half) < t) { lo += half + 1; n -= half + 1; }
+      else n = half;
+    }
+    return lo;
+  }
+  time_t base() const { return base_; }
+
+  // Positionsbereich [lo, hi) für den Zeitbereich einer Abfrage (zwei binäre Suchen)
+  void queryRange(const EventQuery& q, uint32_t& lo, uint32_t& hi) const {
+    lo = q.cutoff ? lowerBoundTs(q.cutoff) : ring_.beginPos();
+    hi = q.until ? lowerBoundTs(q.until + 1) : ring_.endPos();
+    if (q.hasAfter) {
+      const uint32_t from = posAfter(q.afterSeq);
+      if ((int32_t)(from - lo) > 0) lo = from;
+    }
+    if ((int32_t)(hi - lo) < 0) lo = hi; // after in der Zukunft oder until < cutoff
+  }
+
+private:
+  void rebase() {
+    const uint32_t shiftSec = ring_.front().dt / 1000;
+    const uint32_t shiftMs = shiftSec * 1000;
+    for (PackedEvent& p : ring_) p.dt -= shiftMs;
+    base_ += shiftSec;
+  }
+
+  uint32_t offsetAt(uint32_t pos) const {
+    uint32_t off = offset_;
+    for (uint8_t i = 0; i < gapCount_ && (int32_t)(pos - gaps_[i].pos) >= 0; ++i) off = gaps_[i].offset;
+    return off;
+  }
+  uint32_t headOffset() const { return gapCount_ ? gaps_[gapCount_ - 1].offset : offset_; }
+
+  // Lücken, vor denen kein Eintrag mehr liegt, gehen im Grundversatz auf
+  void dropPassedGaps() {
+    uint8_t k = 0;
+    while (k < gapCount_ && (int32_t)(ring_.beginPos() - gaps_[k].pos) >= 0) offset_ = gaps_[k++].offset;
+    for (uint8_t i = k; i < gapCount_; ++i) gaps_[i - k] = gaps_[i];
+    gapCount_ -= k;
+  }
+
+  // Ab Position pos gilt offset (bis zur nächsten Lücke)
+  struct SeqGap {
+    uint32_t pos;
+    uint32_t offset;
+  };
+  static constexpr uint8_t MAX_SEQ_GAPS = 4;
+
+  RingBuffer<PackedEvent, N> ring_;
+  time_t base_ = 0;
+  uint32_t offset_ = 0;          // Versatz vor der ersten Lücke
+  SeqGap gaps_[MAX_SEQ_GAPS];
+  uint8_t gapCount_ = 0;
+};
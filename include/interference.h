@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// =============================
+// Störer-/Rausch-Statistik und automatische AFE-Nachführung
+// =============================
+// Noise-high- und Disturber-Interrupts landen nicht in der Blitz-History, sondern nur hier:
+// Gesamtzähler plus ein Minuten-Histogramm der letzten 60 Minuten (feste Größe, 60 Slots).
+// AfeAutoTuner wertet daraus die Raten aus und schlägt neue AS3935-Einstellungen vor: bei
+// zu vielen Störern wird die Empfindlichkeit schrittweise gesenkt, nach längerer Ruhe wieder
+// in Richtung der Ausgangswerte angehoben. Pro Schritt wird eine Sperrzeit abgewartet, damit
+// die Wirkung der letzten Änderung im Auswertefenster sichtbar ist.
+
+static constexpr uint8_t INT_NOISE = 0x01;     // REG0x03[3:0]: Noise level too high
+static constexpr uint8_t INT_DISTURBER = 0x04; // Disturber detected
+static constexpr uint8_t INT_LIGHTNING = 0x08;
+
+struct InterferenceCounts {
+  uint32_t noise = 0;
+  uint32_t disturber = 0;
+};
+
+class InterferenceStats {
+public:
+  static constexpr uint32_t SLOTS = 60;
+
+  void add(time_t ts, uint8_t intSrc) {
+    const bool noise = intSrc & INT_NOISE;
+    const bool dist = intSrc & INT_DISTURBER;
+    if (!noise && !dist) return;
+    const uint32_t m = minuteOf(ts);
+    Slot& s = slots_[m % SLOTS];
+    if (s.minute != m) s = Slot{m, 0, 0};
+    if (noise) { totals_.noise++; if (s.noise < UINT16_MAX) s.noise++; }
+    if (dist) { totals_.disturber++; if (s.disturber < UINT16_MAX) s.disturber++; }
+  }
+
+  const InterferenceCounts& totals() const { return totals_; }
+
+  // Zähler der Minute, die k Minuten vor now liegt (k = 0: laufende Minute)
+  InterferenceCounts minuteAgo(time_t now, uint32_t k) const {
+    InterferenceCounts c;
+    const uint32_t m = minuteOf(now);
+    if (k >= SLOTS || k > m) return c;
+    const Slot& s = slots_[(m - k) % SLOTS];
+    if (s.minute == m - k) { c.noise = s.noise; c.disturber = s.disturber; }
+    return c;
+  }
+
+  // Summe der letzten minutes Minuten inkl. der laufenden (max. SLOTS)
+  InterferenceCounts window(time_t now, uint32_t minutes) const {
+    InterferenceCounts c;
+    if (minutes > SLOTS) minutes = SLOTS;
+    for (uint32_t k = 0; k < minutes; ++k) {
+      const InterferenceCounts s = minuteAgo(now, k);
+      c.noise += s.noise;
+      c.disturber += s.disturber;
+    }
+    return c;
+  }
+
+private:
+  struct Slot {
+    uint32_t minute = UINT32_MAX;
+    uint16_t noise = 0;
+    uint16_t disturber = 0;
+  };
+
+  static uint32_t minuteOf(time_t t) { return t > 0 ? (uint32_t)(t / 60) : 0; }
+
+  Slot slots_[SLOTS];
+  InterferenceCounts totals_;
+};
+
+// Einstellungen des AS3935-Analogteils
+struct AfeSettings {
+  uint8_t noiseLevel;   // setNoiseLevel 1..7
+  uint8_t watchdog;     // watchdogThreshold 1..10
+  uint8_t spike;        // spikeRejection 1..11
+  bool maskDisturber;   // letzte Stufe: Störer gar nicht mehr melden
+};
+
+inline bool operator==(const AfeSettings& a, const AfeSettings& b) {
+  return a.noiseLevel == b.noiseLevel && a.watchdog == b.watchdog && a.spike == b.spike
+      && a.maskDisturber == b.maskDisturber;
+}
+
+class AfeAutoTuner {
+public:
+  static constexpr uint32_t WINDOW_MIN = 5;             // Auswertefenster
+  static constexpr uint32_t COOLDOWN_SEC = WINDOW_MIN * 60;
+  static constexpr uint32_t RELAX_SEC = 30 * 60;        // so lange ruhig → einen Schritt zurück
+  static constexpr uint32_t DISTURBER_HIGH = 10 * WINDOW_MIN; // > 10/min
+  static constexpr uint32_t DISTURBER_LOW = 1 * WINDOW_MIN;   // ≤ 1/min gilt als ruhig
+  static constexpr uint32_t NOISE_HIGH = 2 * WINDOW_MIN;      // > 2/min
+
+  static constexpr uint8_t NOISE_MAX = 7;
+  static constexpr uint8_t WATCHDOG_MAX = 10;
+  static constexpr uint8_t SPIKE_MAX = 11;
+
+  explicit AfeAutoTuner(const AfeSettings& base) : base_(base), cur_(base) {}
+
+  // Neue Ausgangswerte (/api/config): Nachführung beginnt dort von vorn
+  void setBase(const AfeSettings& base) {
+    base_ = cur_ = base;
+    lastChange_ = quietSince_ = 0;
+  }
+
+  const AfeSettings& settings() const { return cur_; }
+  const AfeSettings& base() const { return base_; }
+  uint32_t adjustments() const { return adjustments_; }
+
+  // Ein Schritt pro Aufruf höchstens; true = cur_ geändert, neue Werte an den Sensor geben
+  bool evaluate(time_t now, const InterferenceStats& s) {
+    if (lastChange_ && now - lastChange_ < (time_t)COOLDOWN_SEC) return false;
+    const InterferenceCounts c = s.window(now, WINDOW_MIN);
+    AfeSettings next = cur_;
+
+    if (c.noise > NOISE_HIGH) {
+      quietSince_ = 0;
+      if (next.noiseLevel < NOISE_MAX) next.noiseLevel++;
+    } else if (c.disturber > DISTURBER_HIGH) {
+      quietSince_ = 0;
+      // Watchdog und Spike-Rejection abwechselnd anheben, zuletzt Störer maskieren
+      if (next.watchdog <= next.spike && next.watchdog < WATCHDOG_MAX) next.watchdog++;
+      else if (next.spike < SPIKE_MAX) next.spike++;
+      else if (next.watchdog < WATCHDOG_MAX) next.watchdog++;
+      else next.maskDisturber = true;
+    } else if (c.disturber <= DISTURBER_LOW && c.noise == 0 && !(cur_ == base_)) {
+      if (!quietSince_) quietSince_ = now;
+      if (now - quietSince_ < (time_t)RELAX_SEC) return false;
+      // zurück in umgekehrter Reihenfolge: erst demaskieren, dann den höchsten Überschuss
+      if (next.maskDisturber && !base_.maskDisturber) next.maskDisturber = false;
+      else if (next.spike > base_.spike && next.spike - base_.spike >= next.watchdog - base_.watchdog) next.spike--;
+      else if (next.watchdog > base_.watchdog) next.watchdog--;
+      else if (next.noiseLevel > base_.noiseLevel) next.noiseLevel--;
+      quietSince_ = now; // nächster Schritt erst nach weiterer Ruhephase
+    } else {
+      quietSince_ = 0;
+    }
+
+    if (next == cur_) return false;
+    cur_ = next;
+    lastChange_ = now;
+    adjustments_++;
+    return true;
+  }
+
+private:
+  AfeSettings base_;
+  AfeSettings cur_;
+  time_t lastChange_ = 0;
+  time_t quietSince_ = 0;
+  uint32_t adjustments_ = 0;
+};
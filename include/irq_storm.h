@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stdint.h>
+
+// =============================
+// IRQ-Sturmschutz (Coalescing + Ratenbegrenzung)
+// =============================
+// Der IRQ-Pin des AS3935 bleibt high, bis das Interruptregister gelesen wurde. Wer das Lesen
+// hinauszögert, begrenzt damit auch die Interruptrate: mehrere Flanken während der Wartezeit
+// werden zu einem Lesevorgang zusammengefasst (Task-Notification mit eSetBits).
+// IrqStormGuard zählt die Flanken pro Sekunde. Über maxPerSec beginnt ein Sturm: Abstand
+// zwischen zwei Lesevorgängen mindestens READ_GAP_MS, Disturber maskiert. Beendet wird er erst,
+// wenn die Rate holdMs lang höchstens die Hälfte der (gedrosselten) Grenze war; kommt der nächste Sturm
+// innerhalb von REARM_MS nach dem Ende, verdoppelt sich die Haltezeit (max. 16-fach), damit
+// Maskieren/Demaskieren nicht im Minutentakt pendelt.
+// Zeitbasis: millis(), Überlauf-fest über Differenzen.
+
+class IrqStormGuard {
+public:
+  static constexpr uint32_t WINDOW_MS = 1000;
+  static constexpr uint32_t READ_GAP_MS = 100;   // im Sturm höchstens 10 Lesevorgänge/s
+  static constexpr uint32_t REARM_MS = 300000;   // erneuter Sturm nach < 5 min → längere Haltezeit
+  static constexpr uint8_t MAX_BACKOFF_SHIFT = 4;
+
+  IrqStormGuard(uint32_t maxPerSec, uint32_t holdMs) : maxPerSec_(maxPerSec), holdMs_(holdMs) {}
+
+  // Nach jedem Lesen des Interruptregisters: edges = ISR-Flanken seit dem letzten Lesen (≥ 1)
+  void onRead(uint32_t nowMs, uint32_t edges) {
+    roll(nowMs);
+    reads_++;
+    edges_ += edges;
+    if (edges > 1) coalesced_ += edges - 1;
+    windowEdges_ += edges;
+    if (!active_ && windowEdges_ > maxPerSec_) enter(nowMs); // nicht erst am Fensterende
+  }
+
+  // Regelmäßig (auch ohne Interrupts) aufrufen; true = Sturmzustand hat gewechselt
+  bool update(uint32_t nowMs) {
+    roll(nowMs);
+    if (active_) {
+      const uint32_t hold = holdMs_ << backoff_;
+      if (quietSince_ && nowMs - quietSince_ >= hold) {
+        active_ = false;
+        changed_ = true;
+        endMs_ = nowMs;
+        quietSince_ = 0;
+      }
+    }
+    const bool changed = changed_;
+    changed_ = false;
+    return changed;
+  }
+
+  bool active() const { return active_; }
+
+  // Wartezeit bis zum nächsten Lesen (zusätzlich zu den 2 ms Pflichtwartezeit)
+  uint32_t readDelayMs(uint32_t nowMs, uint32_t lastReadMs) const {
+    if (!active_) return 0;
+    const uint32_t el = nowMs - lastReadMs;
+    return el < READ_GAP_MS ? READ_GAP_MS - el : 0;
+  }
+
+  uint32_t reads() const { return reads_; }
+  uint32_t edges() const { return edges_; }
+  uint32_t coalesced() const { return coalesced_; }
+  uint32_t storms() const { return storms_; }
+  uint32_t lastRate() const { return lastRate_; }
+  uint32_t holdMs() const { return holdMs_ << backoff_; }
+
+private:
+  void enter(uint32_t nowMs) {
+    if (storms_ && nowMs - endMs_ < REARM_MS) {
+      if (backoff_ < MAX_BACKOFF_SHIFT) backoff_++;
+    } else {
+      backoff_ = 0;
+    }
+    active_ = true;
+    changed_ = true;
+    quietSince_ = 0;
+    storms_++;
+  }
+
+  // Abgelaufene Sekundenfenster abschließen
+  void roll(uint32_t nowMs) {
+    if (!windowStart_) windowStart_ = nowMs ? nowMs : 1;
+    if (nowMs - windowStart_ < WINDOW_MS) return;
+    const bool skipped = nowMs - windowStart_ >= 2 * WINDOW_MS; // Fenster ohne jeden Aufruf
+    const uint32_t rate = skipped ? 0 : windowEdges_;
+    lastRate_ = windowEdges_;
+    windowEdges_ = 0;
+    windowStart_ = nowMs;
+    if (!active_) return;
+    // Im Sturm sind höchstens WINDOW_MS / READ_GAP_MS Flanken pro Fenster möglich (Pin bleibt
+    // bis zum Lesen high), die Ruhe-Schwelle bezieht sich deshalb auf diese Kapazität
+    uint32_t cap = WINDOW_MS / READ_GAP_MS;
+    if (cap > maxPerSec_) cap = maxPerSec_;
+    if (rate * 2 > cap) {
+      quietSince_ = 0;
+    } else if (!quietSince_) {
+      quietSince_ = nowMs;
+    }
+  }
+
+  uint32_t maxPerSec_;
+  uint32_t holdMs_;
+  bool active_ = false;
+  bool changed_ = false;
+  uint8_t backoff_ = 0;
+  uint32_t windowStart_ = 0;
+  uint32_t windowEdges_ = 0;
+  uint32_t lastRate_ = 0;
+  uint32_t quietSince_ = 0;
+  uint32_t endMs_ = 0;
+  uint32_t reads_ = 0;
+  uint32_t edges_ = 0;
+  uint32_t coalesced_ = 0;
+  uint32_t storms_ = 0;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================
+// Distanz → LED-Muster (Lookup-Tabelle)
+// =============================
+// Der AS3935 liefert in REG0x07[5:0] nur 15 Distanzstufen plus 63 (out of range). Aus der
+// Stufentabelle wird zur Compile-Zeit eine 64-Einträge-Tabelle erzeugt: jede Stufe bekommt ihr
+// Muster, nicht gelistete Codes das der nächstgelegenen Stufe (bei Gleichstand die nähere
+// Entfernung), nur 63 schaltet alles aus. Eine Auswertung ist damit ein einziger Array-Zugriff.
+//
+// Maske: Bit0 = LED1 (grün), Bit1 = LED2 (grün), Bit2 = LED3 (gelb), Bit3 = LED4 (rot).
+// Eigene Zuordnung: LED_DISTANCE_MAP vor dem Include (oder per Build-Flag) definieren.
+
+struct LedMapEntry {
+  uint8_t km;
+  uint8_t mask;
+};
+
+#ifndef LED_DISTANCE_MAP
+#define LED_DISTANCE_MAP \
+  {40, 0b0001}, {37, 0b0010}, {34, 0b0011}, {31, 0b0100}, {27, 0b0101}, \
+  {24, 0b0110}, {20, 0b0111}, {17, 0b1000}, {14, 0b1001}, {12, 0b1010}, \
+  {10, 0b1011}, { 8, 0b1100}, { 6, 0b1101}, { 5, 0b1110}, { 1, 0b1111}
+#endif
+
+static constexpr LedMapEntry LED_DISTANCE_TABLE[] = {LED_DISTANCE_MAP};
+static constexpr uint8_t LED_OUT_OF_RANGE_KM = 63;
+static constexpr size_t LED_COUNT = 4;
+
+struct LedLut {
+  uint8_t mask[64];
+  constexpr uint8_t operator[](uint8_t km) const { return mask[km & 63]; }
+};
+
+constexpr LedLut makeLedLut() {
+  LedLut lut{};
+  for (int km = 0; km < 64; ++km) {
+    if (km == LED_OUT_OF_RANGE_KM) { lut.mask[km] = 0; continue; }
+    int best = -1, bestDiff = 64;
+    for (const LedMapEntry& e : LED_DISTANCE_TABLE) {
+      const int diff = e.km > km ? e.km - km : km - e.km;
+      if (diff < bestDiff || (diff == bestDiff && e.km < LED_DISTANCE_TABLE[best].km)) {
+        best = (int)(&e - LED_DISTANCE_TABLE);
+        bestDiff = diff;
+      }
+    }
+    lut.mask[km] = best >= 0 ? LED_DISTANCE_TABLE[best].mask : 0;
+  }
+  return lut;
+}
+
+static constexpr LedLut LED_LUT = makeLedLut();
+
+// Zweite Stufe: LED-Maske (16 Muster) → Bits im GPIO-Ausgangsregister
+struct LedGpioLut {
+  uint32_t bits[1u << LED_COUNT];
+  uint32_t all;
+  constexpr uint32_t operator[](uint8_t mask) const { return bits[mask & ((1u << LED_COUNT) - 1)]; }
+};
+
+constexpr LedGpioLut makeLedGpioLut(int p1, int p2, int p3, int p4) {
+  LedGpioLut lut{};
+  const int pins[LED_COUNT] = {p1, p2, p3, p4};
+  for (uint32_t m = 0; m < (1u << LED_COUNT); ++m) {
+    for (size_t i = 0; i < LED_COUNT; ++i) {
+      if (m & (1u << i)) lut.bits[m] |= 1u << pins[i];
+    }
+  }
+  lut.all = lut.bits[(1u << LED_COUNT) - 1];
+  return lut;
+}
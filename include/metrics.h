@@ -0,0 +1,156 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// =============================
+// Laufzeit-Metriken (Prometheus-Textformat für /api/metrics)
+// =============================
+// Feste Bucket-Grenzen, keine Allokation, observe() ist ein paar Vergleiche und Additionen.
+// Jedes Histogramm hat genau einen Schreiber (Task); der Leser (Metrics-Handler) darf einen
+// halb aktualisierten Stand sehen – für Monitoring unerheblich.
+
+class LatencyHistogram {
+public:
+  static constexpr size_t BUCKETS = 13;
+
+  // Obergrenzen in µs (le="…"), dazu implizit +Inf
+  static const uint32_t* bounds() {
+    static const uint32_t b[BUCKETS] = {50, 100, 250, 500, 1000, 2500, 5000, 10000,
+                                        25000, 50000, 100000, 250000, 1000000};
+    return b;
+  }
+
+  void observe(uint32_t us) {
+    const uint32_t* b = bounds();
+    size_t i = 0;
+    while (i < BUCKETS && us > b[i]) ++i;
+    n_[i]++;
+    count_++;
+    sum_ += us;
+    if (us > max_) max_ = us;
+  }
+
+  uint32_t count() const { return count_; }
+  uint64_t sum() const { return sum_; }
+  uint32_t peak() const { return max_; }
+  uint32_t bucket(size_t i) const { return n_[i]; } // nicht kumulativ, i == BUCKETS → +Inf
+
+private:
+  volatile uint32_t n_[BUCKETS + 1] = {};
+  volatile uint32_t count_ = 0;
+  volatile uint64_t sum_ = 0;
+  volatile uint32_t max_ = 0;
+};
+
+// Ausgabe in einen String-artigen Puffer (Arduino String, std::string, MetricsBuffer:
+// operator+=(const char*))
+
+template <typename Out>
+void appendMetricHeader(Out& out, const char* name, const char* type, const char* help) {
+  char line[192];
+  snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+  out += line;
+}
+
+// Einzelwert; labels ohne geschweifte Klammern (z. B. "op=\"distance\"") oder nullptr
+template <typename Out>
+void appendMetricValue(Out& out, const char* name, const char* labels, unsigned long long v) {
+  char line[160];
+  if (labels && *labels) snprintf(line, sizeof(line), "%s{%s} %llu\n", name, labels, v);
+  else snprintf(line, sizeof(line), "%s %llu\n", name, v);
+  out += line;
+}
+
+// Histogramm: kumulative Buckets, _sum, _count (= +Inf-Bucket, damit beides zusammenpasst)
+template <typename Out>
+void appendHistogram(Out& out, const char* name, const char* labels, const LatencyHistogram& h) {
+  char line[192];
+  const char* sep = (labels && *labels) ? "," : "";
+  if (!labels) labels = "";
+  const uint32_t* b = LatencyHistogram::bounds();
+  unsigned long long cum = 0;
+  for (size_t i = 0; i <= LatencyHistogram::BUCKETS; ++i) {
+    cum += h.bucket(i);
+    if (i < LatencyHistogram::BUCKETS) {
+      snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"%lu\"} %llu\n", name, labels, sep, (unsigned long)b[i], cum);
+    } else {
+      snprintf(line, sizeof(line), "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep, cum);
+    }
+    out += line;
+  }
+  const char* open = *labels ? "{" : "";
+  const char* close = *labels ? "}" : "";
+  snprintf(line, sizeof(line), "%s_sum%s%s%s %llu\n%s_count%s%s%s %llu\n",
+           name, open, labels, close, (unsigned long long)h.sum(),
+           name, open, labels, close, cum);
+  out += line;
+}
+
+// Fester Ausgabepuffer statt eines wachsenden String: nimmt nur ganze Zeilen auf (jedes
+// append* hängt vollständige Zeilen an). Passt eine nicht mehr, fehlt sie und overflowed() meldet es.
+template <size_t N>
+class MetricsBuffer {
+public:
+  static constexpr size_t CAPACITY = N;
+
+  MetricsBuffer& operator+=(const char* s) {
+    const size_t n = strlen(s);
+    if (len_ + n > N) {
+      overflow_ = true;
+      return *this;
+    }
+    memcpy(buf_ + len_, s, n);
+    len_ += n;
+    return *this;
+  }
+
+  const char* data() const { return buf_; }
+  size_t size() const { return len_; }
+  void clear() { len_ = 0; }
+  bool overflowed() const { return overflow_; }
+
+private:
+  char buf_[N];
+  size_t len_ = 0;
+  bool overflow_ = false;
+};
+
+// Seite in Abschnitten für sendStream(): render(out, step) schreibt Abschnitt step in den
+// Puffer und liefert false, wenn es keinen mehr gibt; read() gibt die Abschnitte der Reihe nach
+// aus. Ein Abschnitt muss in N Bytes passen (z. B. ein Histogramm mit Kopf).
+template <size_t N>
+class MetricsStream {
+public:
+  using Render = bool (*)(MetricsBuffer<N>& out, size_t step);
+
+  explicit MetricsStream(Render render) : render_(render) {}
+
+  size_t read(char* out, size_t maxLen) {
+    while (pos_ == buf_.size()) {
+      if (done_) return 0;
+      buf_.clear();
+      pos_ = 0;
+      if (!render_(buf_, step_++)) {
+        done_ = true;
+        return 0;
+      }
+    }
+    size_t n = buf_.size() - pos_;
+    if (n > maxLen) n = maxLen;
+    memcpy(out, buf_.data() + pos_, n);
+    pos_ += n;
+    return n;
+  }
+
+  bool overflowed() const { return buf_.overflowed(); }
+
+private:
+  Render render_;
+  MetricsBuffer<N> buf_;
+  size_t pos_ = 0;
+  size_t step_ = 0;
+  bool done_ = false;
+};
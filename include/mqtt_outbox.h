@@ -0,0 +1,125 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================
+// MQTT-Ausgang: Cursor über die History und Ratenbegrenzung
+// =============================
+// Die History selbst ist die Offline-Queue: PublishCursor merkt sich nur, bis zu welcher seq
+// der Broker bestätigt hat (QoS 1, PUBACK) und welche Nachrichten gerade unterwegs sind.
+// Nach einem Verbindungsabbruch geht es bei der ersten unbestätigten seq weiter; was in der
+// Zwischenzeit dazukam, wird nachgeschickt. Fällt die seq aus der History (oder aus dem
+// Queue-Limit), wird sie übersprungen und als verloren gezählt.
+// Es sind nie mehr als MAX_INFLIGHT Nachrichten unbestätigt, der Speicher des MQTT-Clients
+// bleibt damit begrenzt.
+
+class PublishCursor {
+public:
+  static constexpr size_t MAX_INFLIGHT = 8;
+
+  // Neu beginnen: alles bis einschließlich ackedSeq gilt als zugestellt
+  void start(uint32_t ackedSeq) {
+    acked_ = ackedSeq;
+    next_ = ackedSeq + 1;
+    n_ = 0;
+  }
+
+  // Nächste zu sendende seq; false = nichts zu tun oder Fenster voll.
+  // oldestSeq = älteste noch verfügbare seq, headSeq = neueste.
+  bool next(uint32_t oldestSeq, uint32_t headSeq, uint32_t& seq) {
+    if (n_ == MAX_INFLIGHT) return false;
+    if ((int32_t)(oldestSeq - next_) > 0) {
+      lost_ += oldestSeq - next_;
+      if (!n_) acked_ = oldestSeq - 1;
+      next_ = oldestSeq;
+    }
+    if ((int32_t)(next_ - headSeq) > 0) return false;
+    seq = next_;
+    return true;
+  }
+
+  // seq wurde als Nachricht msgId an den Client übergeben
+  void sent(int msgId, uint32_t seq) {
+    inflight_[n_++] = Inflight{msgId, seq, false};
+    next_ = seq + 1;
+  }
+
+  // Nicht in seq-Reihenfolge übergebbar (z. B. Ereignis fehlt): überspringen ohne Nachricht
+  void skip(uint32_t seq) {
+    next_ = seq + 1;
+    if (!n_) acked_ = seq;
+  }
+
+  // PUBACK: vorne liegende bestätigte Einträge abräumen, acked_ nachziehen
+  void acked(int msgId) {
+    for (size_t i = 0; i < n_; ++i) {
+      if (inflight_[i].msgId == msgId) { inflight_[i].done = true; break; }
+    }
+    size_t k = 0;
+    while (k < n_ && inflight_[k].done) acked_ = inflight_[k++].seq;
+    for (size_t i = k; i < n_; ++i) inflight_[i - k] = inflight_[i];
+    n_ -= k;
+  }
+
+  // Nachricht verworfen (Client-Outbox abgelaufen): ab hier noch einmal senden
+  void failed(int msgId) {
+    for (size_t i = 0; i < n_; ++i) {
+      if (inflight_[i].msgId == msgId) {
+        next_ = inflight_[i].seq;
+        n_ = i;
+        retries_++;
+        return;
+      }
+    }
+  }
+
+  uint32_t ackedSeq() const { return acked_; }
+  size_t inflight() const { return n_; }
+  uint32_t pending(uint32_t headSeq) const { return (int32_t)(headSeq - acked_) > 0 ? headSeq - acked_ : 0; }
+  uint32_t lost() const { return lost_; }
+  uint32_t retries() const { return retries_; }
+
+private:
+  struct Inflight {
+    int msgId;
+    uint32_t seq;
+    bool done;
+  };
+  Inflight inflight_[MAX_INFLIGHT];
+  size_t n_ = 0;
+  uint32_t acked_ = 0;
+  uint32_t next_ = 1;
+  uint32_t lost_ = 0;
+  uint32_t retries_ = 0;
+};
+
+// Token-Bucket: im Mittel perSec Nachrichten, kurzzeitig bis burst
+class RateLimiter {
+public:
+  RateLimiter(uint32_t perSec, uint32_t burst) : perSec_(perSec), burst_(burst), tokens_(burst) {}
+
+  bool take(uint32_t nowMs) {
+    if (!started_) { lastMs_ = nowMs; started_ = true; }
+    const uint32_t elapsed = nowMs - lastMs_;
+    if (elapsed >= REFILL_MS) {
+      tokens_ = burst_; // lange Pause: voll (und kein Überlauf in elapsed * perSec_)
+      lastMs_ = nowMs;
+    } else if (const uint32_t add = elapsed * perSec_ / 1000) {
+      tokens_ = tokens_ + add > burst_ ? burst_ : tokens_ + add;
+      lastMs_ += add * 1000 / perSec_;
+    }
+    if (!tokens_) return false;
+    tokens_--;
+    return true;
+  }
+
+private:
+  static constexpr uint32_t REFILL_MS = 60000;
+
+  uint32_t perSec_;
+  uint32_t burst_;
+  uint32_t tokens_;
+  uint32_t lastMs_ = 0;
+  bool started_ = false;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+// =============================
+// Gesundheitsprüfung nach einem OTA-Update
+// =============================
+// Ein neues Image startet im Zustand „pending verify“: bricht es vor der Bestätigung ab
+// (Absturz, Watchdog), startet der Bootloader wieder das alte. Bestätigt wird erst, wenn das
+// Gerät holdMs lang ununterbrochen gesund war (Sensor läuft, WLAN verbunden) – ein Absturz
+// kurz nach dem Verbinden führt so noch zum Rollback. Ist das nach timeoutMs nicht
+// geschafft, wird aktiv zurückgerollt.
+// Zeitbasis: millis(), Überlauf-fest über Differenzen.
+
+class OtaHealthCheck {
+public:
+  enum class Verdict { Wait, Valid, Rollback };
+
+  OtaHealthCheck(uint32_t holdMs, uint32_t timeoutMs) : holdMs_(holdMs), timeoutMs_(timeoutMs) {}
+
+  void start(uint32_t nowMs) {
+    pending_ = true;
+    startMs_ = nowMs;
+    healthySince_ = 0;
+    healthy_ = false;
+  }
+
+  bool pending() const { return pending_; }
+
+  // Regelmäßig aufrufen; Valid/Rollback kommen genau einmal
+  Verdict update(uint32_t nowMs, bool healthy) {
+    if (!pending_) return Verdict::Wait;
+    if (!healthy) {
+      healthy_ = false;
+    } else if (!healthy_) {
+      healthy_ = true;
+      healthySince_ = nowMs;
+    }
+    if (healthy_ && nowMs - healthySince_ >= holdMs_) {
+      pending_ = false;
+      return Verdict::Valid;
+    }
+    if (nowMs - startMs_ >= timeoutMs_) {
+      pending_ = false;
+      return Verdict::Rollback;
+    }
+    return Verdict::Wait;
+  }
+
+private:
+  uint32_t holdMs_;
+  uint32_t timeoutMs_;
+  uint32_t startMs_ = 0;
+  uint32_t healthySince_ = 0;
+  bool healthy_ = false;
+  bool pending_ = false;
+};
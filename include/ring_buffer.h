@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <iterator>
+
+// =============================
+// Ringpuffer mit fester Kapazität
+// =============================
+// Statisch allokierter Ersatz für std::deque: Speicherbedarf steht zur Compile-Zeit fest,
+// push_back/pop_front fassen den Heap nie an. Kapazität muss eine Zweierpotenz sein, damit
+// der Index per Maske statt per Modulo berechnet wird.
+//
+// head_/tail_ laufen frei (uint32_t) und werden erst beim Zugriff maskiert. Die absolute
+// Position eines Eintrags bleibt damit stabil, solange er im Puffer liegt.
+template <typename T, size_t N>
+class RingBuffer {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "RingBuffer: Kapazitaet muss eine Zweierpotenz sein");
+  static_assert(N <= (size_t(1) << 31), "RingBuffer: Kapazitaet zu gross");
+
+public:
+  static constexpr size_t MASK = N - 1;
+
+  template <typename Owner, typename V>
+  class Iter {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = ptrdiff_t;
+    using pointer = V*;
+    using reference = V&;
+
+    Iter() : rb_(nullptr), pos_(0) {}
+    Iter(Owner* rb, uint32_t pos) : rb_(rb), pos_(pos) {}
+
+    reference operator*() const { return rb_->buf_[pos_ & MASK]; }
+    pointer operator->() const { return &rb_->buf_[pos_ & MASK]; }
+    reference operator[](difference_type n) const { return rb_->buf_[(pos_ + n) & MASK]; }
+
+    Iter& operator++() { ++pos_; return *this; }
+    Iter operator++(int) { Iter t = *this; ++pos_; return t; }
+    Iter& operator--() { --pos_; return *this; }
+    Iter operator--(int) { Iter t = *this; --pos_; return t; }
+    Iter& operator+=(difference_type n) { pos_ += n; return *this; }
+    Iter& operator-=(difference_type n) { pos_ -= n; return *this; }
+    Iter operator+(difference_type n) const { return Iter(rb_, pos_ + n); }
+    Iter operator-(difference_type n) const { return Iter(rb_, pos_ - n); }
+    difference_type operator-(const Iter& o) const { return (difference_type)(int32_t)(pos_ - o.pos_); }
+
+    bool operator==(const Iter& o) const { return pos_ == o.pos_; }
+    bool operator!=(const Iter& o) const { return pos_ != o.pos_; }
+    bool operator<(const Iter& o) const { return (int32_t)(pos_ - o.pos_) < 0; }
+    bool operator>(const Iter& o) const { return o < *this; }
+    bool operator<=(const Iter& o) const { return !(o < *this); }
+    bool operator>=(const Iter& o) const { return !(*this < o); }
+
+    // const_iterator aus iterator erzeugen
+    operator Iter<const Owner, const V>() const { return Iter<const Owner, const V>(rb_, pos_); }
+
+  private:
+    Owner* rb_;
+    uint32_t pos_;
+  };
+
+  using iterator = Iter<RingBuffer, T>;
+  using const_iterator = Iter<const RingBuffer, const T>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  static constexpr size_t capacity() { return N; }
+  size_t size() const { return head_ - tail_; }
+  bool empty() const { return head_ == tail_; }
+  bool full() const { return size() == N; }
+
+  T& front() { return buf_[tail_ & MASK]; }
+  const T& front() const { return buf_[tail_ & MASK]; }
+  T& back() { return buf_[(head_ - 1) & MASK]; }
+  const T& back() const { return buf_[(head_ - 1) & MASK]; }
+
+  // i = 0 ist der älteste Eintrag
+  T& operator[](size_t i) { return buf_[(tail_ + i) & MASK]; }
+  const T& operator[](size_t i) const { return buf_[(tail_ + i) & MASK]; }
+
+  // Hängt an; ist der Puffer voll, wird der älteste Eintrag überschrieben
+  void push_back(const T& v) {
+    if (full()) ++tail_;
+    buf_[head_ & MASK] = v;
+    ++head_;
+  }
+
+  void pop_front() {
+    if (!empty()) ++tail_;
+  }
+
+  void clear() { tail_ = head_; }
+
+  // Leert den Puffer und setzt die absolute Position neu (z. B. beim Wiederherstellen)
+  void resetPos(uint32_t p) { head_ = tail_ = p; }
+
+  // Absolute Positionen: gültig ist beginPos() <= p < endPos(). Bleiben beim Anhängen und
+  // Entfernen stabil – geeignet als Cursor, wenn zwischen zwei Zugriffen eingefügt wird.
+  uint32_t beginPos() const { return tail_; }
+  uint32_t endPos() const { return head_; }
+  bool validPos(uint32_t p) const { return p - tail_ < head_ - tail_; }
+  T& atPos(uint32_t p) { return buf_[p & MASK]; }
+  const T& atPos(uint32_t p) const { return buf_[p & MASK]; }
+
+  iterator begin() { return iterator(this, tail_); }
+  iterator end() { return iterator(this, head_); }
+  const_iterator begin() const { return const_iterator(this, tail_); }
+  const_iterator end() const { return const_iterator(this, head_); }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+private:
+  T buf_[N];
+  uint32_t head_ = 0; // nächste Schreibposition (absolut)
+  uint32_t tail_ = 0; // ältester Eintrag (absolut)
+};
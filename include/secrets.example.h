@@ -9,3 +9,13 @@
 // Zeitzone für Deutschland (CET/CEST). Für Winterzeit +3600, Sommerzeit +7200. NTP passt das meist automatisch.
 #define TZ_OFFSET_SEC 3600
 #define TZ_DST_OFFSET 3600
+
+// MQTT (optional): ohne MQTT_URI ist der Client aus. Topics: MQTT_TOPIC/strike, /live, /trend, /status
+//#define MQTT_URI "mqtt://broker.local:1883"
+//#define MQTT_USER "user"
+//#define MQTT_PASSWORD "password"
+//#define MQTT_TOPIC "lightning"
+
+// OTA-Update (optional): ohne OTA_PASSWORD gibt es /api/ota nicht. Benutzer Default "ota"
+//#define OTA_PASSWORD "geheim"
+//#define OTA_USER "ota"
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// =============================
+// Lock-freie Single-Producer/Single-Consumer-Queue
+// =============================
+// Genau ein Schreiber (z. B. Sensor-Task) und genau ein Leser (z. B. loop()). Kein Mutex,
+// keine kritische Sektion: head_ wird nur vom Schreiber, tail_ nur vom Leser verändert.
+// Es werden nur atomare Loads/Stores gebraucht – die gibt es auch auf dem ESP32-C3 (RV32IMC
+// ohne A-Extension) ohne libatomic-Emulation. Kapazität muss eine Zweierpotenz sein.
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue: Kapazitaet muss eine Zweierpotenz sein");
+
+public:
+  static constexpr size_t capacity() { return N; }
+
+  // Nur vom Schreiber aufrufen; false = Queue voll, Element verworfen
+  bool push(const T& v) {
+    const uint32_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) >= N) return false;
+    buf_[h & (N - 1)] = v;
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Nur vom Leser aufrufen; false = Queue leer
+  bool pop(T& out) {
+    const uint32_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire)) return false;
+    out = buf_[t & (N - 1)];
+    tail_.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+
+private:
+  T buf_[N];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+};
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// =============================
+// Inkrementelle Statistik für /api/stats
+// =============================
+// Pro Minute ein Slot mit den Zählern je Distanz-Bucket (1440 Slots = 24h, ~29 KB).
+// Ereignisse werden beim Einfügen gezählt, abgelaufene Minuten beim Nachziehen (advance)
+// aus den laufenden Summen ausgetragen. Für die Standardfenster (5/15/60/1440 min) liegt das
+// Ergebnis damit fertig vor, beliebige Bereiche summieren höchstens 1440 Slots – unabhängig
+// davon, wie viele Ereignisse gespeichert sind. Auflösung: 1 Minute (angefangene Minute zählt mit).
+// Jeder Slot führt außerdem kleinste Distanz, Distanzsumme und größte Energie der Minute mit;
+// daraus liefert series() vorgebinnte Reihen für die Dashboard-Diagramme (/api/series).
+
+struct StatsBuckets {
+  uint32_t near = 0;  // ≤ 5 km
+  uint32_t mid = 0;   // 6..15 km
+  uint32_t far_ = 0;  // > 15 km
+  uint32_t oor = 0;   // 63 = out of range
+  uint32_t count() const { return near + mid + far_ + oor; }
+};
+
+// Ein Bin von series(); Distanzwerte nur über Blitze mit Distanz (ohne 63 = out of range)
+struct SeriesBin {
+  uint32_t count = 0;     // alle Blitze
+  uint32_t nKm = 0;       // davon mit Distanz
+  uint32_t sumKm = 0;
+  uint8_t minKm = 63;     // 63 = keine Distanz im Bin
+  uint32_t maxEnergy = 0;
+  float avgKm() const { return nKm ? (float)sumKm / nKm : -1; }
+};
+
+enum DistanceBucket : uint8_t { BUCKET_NEAR, BUCKET_MID, BUCKET_FAR, BUCKET_OOR };
+
+inline DistanceBucket distanceBucket(uint8_t km) {
+  if (km == 63) return BUCKET_OOR;
+  if (km <= 5) return BUCKET_NEAR;
+  if (km <= 15) return BUCKET_MID;
+  return BUCKET_FAR;
+}
+
+class MinuteAggregates {
+public:
+  static constexpr uint32_t SLOTS = 1440;
+  static constexpr size_t WINDOW_COUNT = 4;
+
+  // Standardfenster in Minuten, für die laufende Summen gepflegt werden
+  static uint32_t windowMinutes(size_t i) {
+    static const uint32_t W[WINDOW_COUNT] = {5, 15, 60, SLOTS};
+    return W[i];
+  }
+
+  void clear() {
+    for (uint32_t i = 0; i < SLOTS; ++i) slots_[i] = Slot();
+    for (size_t i = 0; i < WINDOW_COUNT; ++i) totals_[i] = StatsBuckets();
+    started_ = false;
+  }
+
+  // Fenster auf die aktuelle Zeit nachziehen (im selben Schritt wie trimHistoryOlderThan)
+  void advance(time_t now) {
+    const uint32_t m = minuteOf(now);
+    if (!started_) {
+      started_ = true;
+      cur_ = m;
+      for (size_t i = 0; i < WINDOW_COUNT; ++i) begin_[i] = windowBegin(m, windowMinutes(i));
+      return;
+    }
+    if (m == cur_) return;
+    if (m < cur_) { // Uhr wurde zurückgestellt (NTP) → einmalig neu aufsummieren
+      cur_ = m;
+      rebuild();
+      return;
+    }
+    cur_ = m;
+    for (size_t i = 0; i < WINDOW_COUNT; ++i) {
+      const uint32_t w = windowMinutes(i);
+      const uint32_t nb = windowBegin(m, w);
+      if (nb - begin_[i] >= w) {
+        totals_[i] = StatsBuckets();
+      } else {
+        for (uint32_t b = begin_[i]; b < nb; ++b) {
+          const Slot& s = slots_[b % SLOTS];
+          if (s.minute == b) sub(totals_[i], s);
+        }
+      }
+      begin_[i] = nb;
+    }
+  }
+
+  void add(time_t ts, uint8_t distance, uint32_t energy = 0) {
+    const uint32_t m = minuteOf(ts);
+    if (!started_ || m > cur_) advance(ts);
+    if (m < begin_[WINDOW_COUNT - 1]) return; // älter als 24h
+
+    Slot& s = slots_[m % SLOTS];
+    if (s.minute != m) { s = Slot(); s.minute = m; }
+    const DistanceBucket b = distanceBucket(distance);
+    s.n[b]++;
+    if (b != BUCKET_OOR) {
+      s.sumKm += distance;
+      if (distance < s.minKm) s.minKm = distance;
+    }
+    if (energy > s.maxEnergy) s.maxEnergy = energy > SLOT_ENERGY_MAX ? SLOT_ENERGY_MAX : energy;
+    for (size_t i = 0; i < WINDOW_COUNT; ++i) {
+      if (m >= begin_[i]) inc(totals_[i], b);
+    }
+  }
+
+  // Zähler der letzten rangeSec Sekunden (auf ganze Minuten aufgerundet, max. 24h)
+  StatsBuckets query(long rangeSec) const {
+    StatsBuckets r;
+    if (!started_) return r;
+    const uint32_t k = minutesFor(rangeSec);
+    for (size_t i = 0; i < WINDOW_COUNT; ++i) {
+      if (windowMinutes(i) == k) return totals_[i];
+    }
+    for (uint32_t b = windowBegin(cur_, k); b <= cur_; ++b) {
+      const Slot& s = slots_[b % SLOTS];
+      if (s.minute == b) addSlot(r, s);
+    }
+    return r;
+  }
+
+  // bins Bins zu je binMinutes Minuten, Index 0 = Bin mit der laufenden Minute, dann rückwärts.
+  // Liest höchstens SLOTS Slots; Minuten vor dem 24-h-Fenster bleiben leer.
+  void series(uint32_t binMinutes, size_t bins, SeriesBin* out) const {
+    for (size_t i = 0; i < bins; ++i) out[i] = SeriesBin();
+    if (!started_ || !binMinutes) return;
+    const uint32_t first = begin_[WINDOW_COUNT - 1];
+    for (size_t i = 0; i < bins; ++i) {
+      for (uint32_t k = 0; k < binMinutes; ++k) {
+        const uint64_t back = (uint64_t)i * binMinutes + k;
+        if (back > cur_ || cur_ - back < first) return;
+        const uint32_t m = cur_ - (uint32_t)back;
+        const Slot& s = slots_[m % SLOTS];
+        if (s.minute != m) continue;
+        SeriesBin& b = out[i];
+        const uint32_t withKm = s.n[BUCKET_NEAR] + s.n[BUCKET_MID] + s.n[BUCKET_FAR];
+        b.count += withKm + s.n[BUCKET_OOR];
+        b.nKm += withKm;
+        b.sumKm += s.sumKm;
+        if (withKm && s.minKm < b.minKm) b.minKm = s.minKm;
+        if (s.maxEnergy > b.maxEnergy) b.maxEnergy = s.maxEnergy;
+      }
+    }
+  }
+
+  // Laufende Minute (Minuten seit Epoch); Bin i von series() endet vor (currentMinute() + 1 - i * binMinutes) * 60
+  uint32_t currentMinute() const { return cur_; }
+
+  static uint32_t minutesFor(long rangeSec) {
+    if (rangeSec <= 60) return 1;
+    uint32_t k = (uint32_t)((rangeSec + 59) / 60);
+    if (k > SLOTS) k = SLOTS;
+    return k;
+  }
+
+private:
+  static constexpr uint32_t SLOT_ENERGY_MAX = (1u << 24) - 1;
+
+  struct Slot {
+    Slot() : maxEnergy(0), minKm(63) {}
+    uint32_t minute = UINT32_MAX; // Minute seit Epoch, UINT32_MAX = leer
+    uint16_t n[4] = {0, 0, 0, 0}; // Zähler je DistanceBucket
+    uint32_t sumKm = 0;           // Summe der Distanzen (ohne out of range)
+    uint32_t maxEnergy : 24;      // Rohwert hat 21 Bit
+    uint32_t minKm : 8;
+  };
+
+  static uint32_t minuteOf(time_t t) { return t > 0 ? (uint32_t)(t / 60) : 0; }
+  static uint32_t windowBegin(uint32_t m, uint32_t w) { return m + 1 >= w ? m + 1 - w : 0; }
+
+  static void inc(StatsBuckets& t, DistanceBucket b) {
+    switch (b) {
+      case BUCKET_NEAR: t.near++; break;
+      case BUCKET_MID:  t.mid++;  break;
+      case BUCKET_FAR:  t.far_++; break;
+      case BUCKET_OOR:  t.oor++;  break;
+    }
+  }
+  static void addSlot(StatsBuckets& t, const Slot& s) {
+    t.near += s.n[BUCKET_NEAR]; t.mid += s.n[BUCKET_MID]; t.far_ += s.n[BUCKET_FAR]; t.oor += s.n[BUCKET_OOR];
+  }
+  static void sub(StatsBuckets& t, const Slot& s) {
+    t.near -= s.n[BUCKET_NEAR]; t.mid -= s.n[BUCKET_MID]; t.far_ -= s.n[BUCKET_FAR]; t.oor -= s.n[BUCKET_OOR];
+  }
+
+  void rebuild() {
+    for (size_t i = 0; i < WINDOW_COUNT; ++i) {
+      totals_[i] = StatsBuckets();
+      begin_[i] = windowBegin(cur_, windowMinutes(i));
+      for (uint32_t b = begin_[i]; b <= cur_; ++b) {
+        const Slot& s = slots_[b % SLOTS];
+        if (s.minute == b) addSlot(totals_[i], s);
+      }
+    }
+  }
+
+  Slot slots_[SLOTS];
+  StatsBuckets totals_[WINDOW_COUNT];
+  uint32_t begin_[WINDOW_COUNT] = {0, 0, 0, 0}; // erste Minute je Fenster
+  uint32_t cur_ = 0;                             // aktuelle Minute
+  bool started_ = false;
+};
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// =============================
+// Gewitter-Trend (Rate, Annäherung, Warnstufe)
+// =============================
+// Läuft inkrementell bei jedem Blitz, O(1), ohne Blick in die History:
+// - Blitzrate: exponentiell gewichtet (Zeitkonstante RATE_TAU_SEC), in Blitzen/min
+// - Annäherung: gewichtete lineare Regression Distanz über Zeit mit exponentiellem Vergessen
+//   (REG_TAU_SEC). Gepflegt werden nur die Summen S0, St, Sd, Stt, Std relativ zum letzten
+//   Blitz; vor jedem neuen Punkt werden sie gedämpft und auf den neuen Nullpunkt verschoben.
+//   Steigung → Annäherungsgeschwindigkeit, Achsenabschnitt → geschätzte aktuelle Distanz,
+//   beides zusammen → ETA bis 0 km.
+// - Warnstufe mit Hysterese: hoch sofort, runter erst mit Abstand zur Schwelle und nachdem die
+//   niedrigere Stufe HOLD_SEC lang zutrifft; ohne Blitze seit QUIET_SEC zurück auf NONE.
+// Distanz 63 (out of range) zählt zur Rate, nicht zur Regression.
+
+enum AlertLevel : uint8_t { ALERT_NONE = 0, ALERT_WATCH = 1, ALERT_WARNING = 2, ALERT_DANGER = 3 };
+
+inline const char* alertLevelName(uint8_t l) {
+  switch (l) {
+    case ALERT_WATCH: return "watch";
+    case ALERT_WARNING: return "warning";
+    case ALERT_DANGER: return "danger";
+    default: return "none";
+  }
+}
+
+struct TrendSnapshot {
+  float ratePerMin = 0;     // gewichtete Blitzrate
+  float distanceKm = -1;    // geschätzte aktuelle Distanz, -1 = unbekannt
+  float approachKmh = 0;    // > 0 = kommt näher, < 0 = zieht ab
+  float etaMin = -1;        // Minuten bis 0 km, -1 = kommt nicht näher / zu wenig Daten
+  bool regression = false;  // approachKmh/etaMin aus der Regression (sonst nur Mittelwert)
+  uint8_t level = ALERT_NONE;
+  uint32_t strikes = 0;     // Blitze seit Start
+  time_t lastTs = 0;        // Zeit des letzten Blitzes
+};
+
+class StormTrend {
+public:
+  static constexpr float RATE_TAU_SEC = 300;   // Blitzrate: 5 min
+  static constexpr float REG_TAU_SEC = 900;    // Regression: 15 min
+  static constexpr float MIN_WEIGHT = 3;       // effektive Punktzahl für eine Regression
+  static constexpr float MIN_SPREAD_SEC = 120; // gewichtete Streuung der Zeitpunkte
+  static constexpr float MIN_APPROACH_KMH = 1; // darunter keine ETA
+  static constexpr uint32_t HOLD_SEC = 300;    // Dauer, bevor eine Stufe fällt
+  static constexpr uint32_t QUIET_SEC = 900;   // ohne Blitze → NONE
+
+  // Stufengrenzen (km): Eintritt / Austritt
+  static constexpr float DANGER_ENTER_KM = 10, DANGER_EXIT_KM = 14;
+  static constexpr float WARNING_ENTER_KM = 20, WARNING_EXIT_KM = 25;
+  static constexpr float WARNING_ETA_ENTER_MIN = 15, WARNING_ETA_EXIT_MIN = 20;
+  static constexpr float WATCH_MAX_KM = 40;
+
+  void clear() { *this = StormTrend(); }
+
+  void update(time_t ts, uint8_t distance) {
+    if (strikes_ && ts < lastTs_) ts = lastTs_; // Uhr zurückgestellt → als gleichzeitig werten
+    const float dt = strikes_ ? (float)(ts - lastTs_) : 0;
+
+    rate_ = rate_ * expf(-dt / RATE_TAU_SEC) + 60.0f / RATE_TAU_SEC;
+
+    if (distance != 63) {
+      // Summen dämpfen und auf den neuen Nullpunkt (dieser Blitz) verschieben
+      const float w = expf(-(float)(ts - regTs_) / REG_TAU_SEC);
+      const float sh = (float)(regTs_ - ts); // alte Zeitpunkte werden negativ
+      s0_ *= w; st_ *= w; sd_ *= w; stt_ *= w; stdd_ *= w;
+      stt_ += 2 * sh * st_ + sh * sh * s0_;
+      stdd_ += sh * sd_;
+      st_ += sh * s0_;
+      regTs_ = ts;
+      // neuer Punkt bei t = 0
+      s0_ += 1;
+      sd_ += distance;
+    }
+
+    lastTs_ = ts;
+    strikes_++;
+    evaluate(ts);
+  }
+
+  // Zeitabhängige Teile (Rate abklingen lassen, Stufe senken); aus loop()/Task regelmäßig
+  void advance(time_t now) {
+    if (strikes_) evaluate(now);
+  }
+
+  TrendSnapshot snapshot(time_t now) const {
+    TrendSnapshot t;
+    t.strikes = strikes_;
+    t.lastTs = lastTs_;
+    t.level = level_;
+    if (!strikes_) return t;
+    const float age = now > lastTs_ ? (float)(now - lastTs_) : 0;
+    t.ratePerMin = rate_ * expf(-age / RATE_TAU_SEC);
+    estimate(now, t);
+    return t;
+  }
+
+  uint8_t level() const { return level_; }
+
+  // Zeitbasis verschieben (z. B. Sekunden seit Boot → Unix-Zeit nach der ersten NTP-Synchronisation).
+  // Die Regressionssummen sind relativ zu regTs_ und bleiben unverändert.
+  void rebase(time_t offset) {
+    if (!strikes_) return;
+    regTs_ += offset;
+    lastTs_ += offset;
+    if (downSince_) downSince_ += offset;
+  }
+
+private:
+  // Distanz/Steigung aus den Summen, bezogen auf now
+  void estimate(time_t now, TrendSnapshot& t) const {
+    if (s0_ <= 0) return;
+    const float age = now > regTs_ ? (float)(now - regTs_) : 0;
+    const float det = s0_ * stt_ - st_ * st_;
+    if (s0_ >= MIN_WEIGHT && det > s0_ * s0_ * MIN_SPREAD_SEC * MIN_SPREAD_SEC) {
+      const float slope = (s0_ * stdd_ - st_ * sd_) / det; // km/s
+      const float icpt = (sd_ - slope * st_) / s0_;       // km beim letzten Blitz
+      float d = icpt + slope * age;
+      if (d < 0) d = 0;
+      t.distanceKm = d;
+      t.approachKmh = -slope * 3600;
+      t.regression = true;
+      if (t.approachKmh >= MIN_APPROACH_KMH) t.etaMin = d / t.approachKmh * 60;
+    } else {
+      t.distanceKm = sd_ / s0_;
+    }
+  }
+
+  uint8_t target(const TrendSnapshot& t, bool exit) const {
+    if (t.distanceKm < 0) return ALERT_NONE;
+    const float d = t.distanceKm;
+    if (d <= (exit ? DANGER_EXIT_KM : DANGER_ENTER_KM)) return ALERT_DANGER;
+    if (d <= (exit ? WARNING_EXIT_KM : WARNING_ENTER_KM)) return ALERT_WARNING;
+    if (t.etaMin >= 0 && t.etaMin <= (exit ? WARNING_ETA_EXIT_MIN : WARNING_ETA_ENTER_MIN)) return ALERT_WARNING;
+    if (d <= WATCH_MAX_KM) return ALERT_WATCH;
+    return ALERT_NONE;
+  }
+
+  void evaluate(time_t now) {
+    if (now - lastTs_ >= (time_t)QUIET_SEC) {
+      level_ = ALERT_NONE;
+      downSince_ = 0;
+      return;
+    }
+    TrendSnapshot t;
+    estimate(now, t);
+    const uint8_t up = target(t, false);
+    if (up >= level_) {
+      level_ = up;
+      downSince_ = 0;
+      return;
+    }
+    // Absenken nur, wenn auch die Austrittsschwellen unterschritten sind – und lange genug
+    const uint8_t down = target(t, true);
+    if (down >= level_) { downSince_ = 0; return; }
+    if (!downSince_) { downSince_ = now ? now : 1; return; }
+    if (now - downSince_ >= (time_t)HOLD_SEC) {
+      level_ = down;
+      downSince_ = 0;
+    }
+  }
+
+  float rate_ = 0;
+  float s0_ = 0, st_ = 0, sd_ = 0, stt_ = 0, stdd_ = 0;
+  time_t regTs_ = 0;     // Nullpunkt der Regressionssummen
+  time_t lastTs_ = 0;
+  uint32_t strikes_ = 0;
+  uint8_t level_ = ALERT_NONE;
+  time_t downSince_ = 0; // seit wann eine niedrigere Stufe zutrifft
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "event_store.h"
+#include "event_binary.h"
+
+// =============================
+// Blitz-Datagramm für den Push an Nachbarknoten und Collector (UDP-Multicast)
+// =============================
+// Statt dass der Collector jeden Knoten per HTTP abfragt, schickt jeder Knoten neue Blitze
+// selbst: ein kleines Datagramm pro Blitz bzw. pro Burst (Blitze innerhalb von wenigen ms
+// werden in StrikeBatch gesammelt). Alle Felder little-endian. Format (Version 1):
+//
+//   Offset Größe  Feld
+//   0      2      Magic "LB"
+//   2      1      Version (1)
+//   3      1      Anzahl Einträge n (1..STRIKE_BATCH_MAX)
+//   4      4      Knoten-ID (nodeIdFromMac: MAC-Bytes 3..5, darüber die gefaltete OUI)
+//   8      4      seq des ersten Eintrags (wie /api/events; folgende: seq+1, seq+2, …)
+//   12     12*n   Einträge, älteste zuerst:
+//                   int64  ts   : Unix-Zeit in Millisekunden
+//                   uint32 bits : wie /api/events.bin ([5:0] Distanz km, [26:6] Energie,
+//                                 [30:27] Interruptquelle, [31] irq)
+
+static constexpr uint8_t STRIKE_PKT_VERSION = 1;
+static constexpr size_t STRIKE_PKT_HEADER_SIZE = 12;
+static constexpr size_t STRIKE_PKT_ENTRY_SIZE = 12;
+static constexpr size_t STRIKE_BATCH_MAX = 16;
+static constexpr size_t STRIKE_PKT_MAX = STRIKE_PKT_HEADER_SIZE + STRIKE_BATCH_MAX * STRIKE_PKT_ENTRY_SIZE;
+
+// Knoten-ID aus der MAC (mac[0] zuerst wie gedruckt). mac[0..2] ist die Herstellerkennung (OUI),
+// gerätespezifisch sind nur mac[3..5] – die bilden die unteren 24 Bit, innerhalb einer OUI also
+// eindeutig. Das obere Byte (XOR der OUI-Bytes) trennt Boards mit verschiedenen OUIs.
+inline uint32_t nodeIdFromMac(const uint8_t mac[6]) {
+  return (uint32_t)(mac[0] ^ mac[1] ^ mac[2]) << 24 | (uint32_t)mac[3] << 16 | mac[4] << 8 | mac[5];
+}
+
+inline uint32_t getLe32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+inline uint64_t getLe64(const uint8_t* p) { return getLe32(p) | (uint64_t)getLe32(p + 4) << 32; }
+
+// Sammelt aufeinanderfolgende Blitze für ein Datagramm. Voll, Lücke in der seq oder
+// windowMs seit dem ersten Eintrag → senden (encode) und leeren.
+class StrikeBatch {
+public:
+  size_t size() const { return n_; }
+  bool empty() const { return n_ == 0; }
+  void clear() { n_ = 0; }
+
+  // false = passt nicht mehr hinein (voll oder seq nicht fortlaufend): erst senden
+  bool add(const LightningEvent& e, uint32_t seq, uint32_t nowMs) {
+    if (n_ == STRIKE_BATCH_MAX || (n_ && seq != firstSeq_ + n_)) return false;
+    if (!n_) { firstSeq_ = seq; firstMs_ = nowMs; }
+    const PackedEvent p = packEvent(e, e.ts); // nur die Bits, dt = ms
+    ts_[n_] = (int64_t)e.ts * 1000 + e.ms;
+    bits_[n_] = p.bits;
+    n_++;
+    return true;
+  }
+
+  bool due(uint32_t nowMs, uint32_t windowMs) const {
+    return n_ && (n_ == STRIKE_BATCH_MAX || nowMs - firstMs_ >= windowMs);
+  }
+
+  // Restzeit bis due() (für die Wartezeit in loop()), 0 = jetzt; nur bei !empty()
+  uint32_t remainingMs(uint32_t nowMs, uint32_t windowMs) const {
+    const uint32_t age = nowMs - firstMs_;
+    return n_ == STRIKE_BATCH_MAX || age >= windowMs ? 0 : windowMs - age;
+  }
+
+  // out muss STRIKE_PKT_MAX Byte fassen; liefert die Länge
+  size_t encode(uint8_t* out, uint32_t nodeId) const {
+    out[0] = 'L';
+    out[1] = 'B';
+    out[2] = STRIKE_PKT_VERSION;
+    out[3] = (uint8_t)n_;
+    putLe32(out + 4, nodeId);
+    putLe32(out + 8, firstSeq_);
+    uint8_t* p = out + STRIKE_PKT_HEADER_SIZE;
+    for (size_t i = 0; i < n_; ++i, p += STRIKE_PKT_ENTRY_SIZE) {
+      putLe64(p, (uint64_t)ts_[i]);
+      putLe32(p + 8, bits_[i]);
+    }
+    return STRIKE_PKT_HEADER_SIZE + n_ * STRIKE_PKT_ENTRY_SIZE;
+  }
+
+private:
+  int64_t ts_[STRIKE_BATCH_MAX];
+  uint32_t bits_[STRIKE_BATCH_MAX];
+  size_t n_ = 0;
+  uint32_t firstSeq_ = 0;
+  uint32_t firstMs_ = 0;
+};
+
+struct StrikePacket {
+  uint32_t nodeId;
+  uint32_t firstSeq;
+  uint8_t count;
+  const uint8_t* entries;
+};
+
+// Prüft Magic, Version und Länge; unbekannte Versionen werden verworfen
+inline bool decodeStrikePacket(const uint8_t* buf, size_t len, StrikePacket& pkt) {
+  if (len < STRIKE_PKT_HEADER_SIZE || buf[0] != 'L' || buf[1] != 'B' || buf[2] != STRIKE_PKT_VERSION) return false;
+  pkt.count = buf[3];
+  if (!pkt.count || pkt.count > STRIKE_BATCH_MAX || len != STRIKE_PKT_HEADER_SIZE + pkt.count * STRIKE_PKT_ENTRY_SIZE) return false;
+  pkt.nodeId = getLe32(buf + 4);
+  pkt.firstSeq = getLe32(buf + 8);
+  pkt.entries = buf + STRIKE_PKT_HEADER_SIZE;
+  return true;
+}
+
+inline LightningEvent strikePacketEvent(const StrikePacket& pkt, size_t i) {
+  const uint8_t* p = pkt.entries + i * STRIKE_PKT_ENTRY_SIZE;
+  const int64_t tsMs = (int64_t)getLe64(p);
+  PackedEvent pe;
+  pe.dt = 0;
+  pe.bits = getLe32(p + 8);
+  const time_t sec = (time_t)(tsMs >= 0 ? tsMs / 1000 : 0);
+  LightningEvent e = unpackEvent(pe, sec);
+  e.ms = (uint16_t)(tsMs - (int64_t)sec * 1000);
+  return e;
+}
+
+// =============================
+// Letzte Blitze der Nachbarknoten
+// =============================
+// Pro Knoten nur der jüngste Blitz (Distanz gilt vom Standort des Knotens aus). nearestKm()
+// liefert die kleinste Distanz aller Knoten, deren letzter Blitz höchstens maxAgeSec alt ist –
+// daraus zeigen die LEDs ein gemeinsames „nächstes Gewitter“. Ist die Tabelle voll, ersetzt ein
+// neuer Knoten den mit dem ältesten Blitz.
+struct PeerStrike {
+  uint32_t nodeId = 0;
+  time_t ts = 0;
+  uint8_t distance = 63;
+  uint32_t strikes = 0;  // empfangene Blitze
+  uint32_t lastSeq = 0;
+  uint32_t lost = 0;     // Lücken in der seq (verlorene Datagramme)
+};
+
+template <size_t N>
+class PeerTable {
+public:
+  size_t size() const { return n_; }
+  const PeerStrike& operator[](size_t i) const { return peers_[i]; }
+
+  void add(uint32_t nodeId, uint32_t seq, const LightningEvent& e) {
+    PeerStrike& p = find(nodeId);
+    if (p.strikes && seq == p.lastSeq) return; // doppelt empfangen
+    // seq rückwärts: Knoten neu gestartet, keine Lücke zählen
+    if (p.strikes && (int32_t)(seq - p.lastSeq) > 1) p.lost += seq - p.lastSeq - 1;
+    p.lastSeq = seq;
+    p.strikes++;
+    if (e.ts >= p.ts) {
+      p.ts = e.ts;
+      p.distance = e.distance;
+    }
+  }
+
+  // -1 = kein Knoten mit aktuellem Blitz in Reichweite
+  int nearestKm(time_t now, uint32_t maxAgeSec) const {
+    int best = -1;
+    for (size_t i = 0; i < n_; ++i) {
+      const PeerStrike& p = peers_[i];
+      if (p.distance == 63 || now - p.ts > (time_t)maxAgeSec) continue;
+      if (best < 0 || p.distance < best) best = p.distance;
+    }
+    return best;
+  }
+
+private:
+  PeerStrike& find(uint32_t nodeId) {
+    size_t oldest = 0;
+    for (size_t i = 0; i < n_; ++i) {
+      if (peers_[i].nodeId == nodeId) return peers_[i];
+      if (peers_[i].ts < peers_[oldest].ts) oldest = i;
+    }
+    PeerStrike& p = peers_[n_ < N ? n_++ : oldest];
+    p = PeerStrike();
+    p.nodeId = nodeId;
+    return p;
+  }
+
+  PeerStrike peers_[N];
+  size_t n_ = 0;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+
+// =============================
+// Bausteine des Supervisor-Tasks (Selbstheilung)
+// =============================
+// Der Supervisor prüft im Sekundentakt, ob Sensor-Task und loop() weiterlaufen, ob der AS3935
+// noch plausibel antwortet, ob das WLAN wiederkommt und ob der Heap reicht. Die Entscheidungen
+// stecken in diesen kleinen Klassen (ohne Hardware, auf dem Host testbar); was dann passiert
+// (Bus freitakten, initAS3935, WiFi.begin, esp_restart), steht in main.cpp.
+// Zeitbasis: millis(), Überlauf-fest über Differenzen.
+
+// Exponentieller Backoff für Wiederholungen: minMs, 2·minMs, … bis maxMs.
+// arm() nach einem Fehlschlag (mehrfach harmlos), take() = jetzt erneut versuchen; bleibt
+// der Versuch ohne Ergebnis, ist nach der nächsten Wartezeit wieder take() an der Reihe.
+class RetryBackoff {
+public:
+  RetryBackoff(uint32_t minMs, uint32_t maxMs) : minMs_(minMs), maxMs_(maxMs) {}
+
+  void arm(uint32_t nowMs) {
+    if (armed_) return;
+    armed_ = true;
+    dueMs_ = nowMs + delayMs();
+  }
+
+  bool take(uint32_t nowMs) {
+    if (!armed_ || (int32_t)(nowMs - dueMs_) < 0) return false;
+    if (delayMs() < maxMs_) step_++;
+    attempts_++;
+    dueMs_ = nowMs + delayMs();
+    return true;
+  }
+
+  // Erfolg: nächste Störung beginnt wieder bei minMs
+  void reset() {
+    armed_ = false;
+    step_ = 0;
+  }
+
+  bool armed() const { return armed_; }
+  uint32_t attempts() const { return attempts_; }
+  uint32_t delayMs() const {
+    const uint32_t d = step_ < 31 ? minMs_ << step_ : maxMs_;
+    return d > maxMs_ || d < minMs_ ? maxMs_ : d;
+  }
+
+private:
+  uint32_t minMs_;
+  uint32_t maxMs_;
+  uint32_t dueMs_ = 0;
+  uint32_t attempts_ = 0;
+  uint8_t step_ = 0;
+  bool armed_ = false;
+};
+
+// Herzschlag eines Tasks: der Task zählt beat hoch, update() meldet true, sobald sich der
+// Zähler limitMs lang nicht mehr bewegt hat
+class StallDetector {
+public:
+  explicit StallDetector(uint32_t limitMs) : limitMs_(limitMs) {}
+
+  bool update(uint32_t beat, uint32_t nowMs) {
+    if (!started_ || beat != lastBeat_) {
+      started_ = true;
+      lastBeat_ = beat;
+      lastMs_ = nowMs;
+      return false;
+    }
+    return nowMs - lastMs_ >= limitMs_;
+  }
+
+private:
+  uint32_t limitMs_;
+  uint32_t lastBeat_ = 0;
+  uint32_t lastMs_ = 0;
+  bool started_ = false;
+};
+
+// Erst nach limit Fehlschlägen in Folge handeln (Ausreißer ignorieren)
+class FailureStreak {
+public:
+  explicit FailureStreak(uint32_t limit) : limit_(limit) {}
+
+  // true = Grenze erreicht, Zähler beginnt von vorn
+  bool report(bool ok) {
+    if (ok) {
+      streak_ = 0;
+      return false;
+    }
+    if (++streak_ < limit_) return false;
+    streak_ = 0;
+    return true;
+  }
+
+  uint32_t streak() const { return streak_; }
+
+private:
+  uint32_t limit_;
+  uint32_t streak_ = 0;
+};
@@ -0,0 +1,50 @@
+# PlatformIO Pre-Build-Skript: packt data/index.html als gzip-Blob in include/dashboard_gz.h.
+# Der Blob landet im Flash (PROGMEM) und wird von handleRoot() unverändert ausgeliefert.
+# ETag = Hash über den komprimierten Inhalt → ändert sich nur, wenn sich die Seite ändert.
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821 (von PlatformIO bereitgestellt)
+    PROJECT_DIR = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SRC = os.path.join(PROJECT_DIR, "data", "index.html")
+DST = os.path.join(PROJECT_DIR, "include", "dashboard_gz.h")
+
+
+def embed():
+    with open(SRC, "rb") as f:
+        html = f.read()
+    # mtime=0 → reproduzierbare Ausgabe (gleiche Seite = gleicher ETag)
+    blob = gzip.compress(html, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(blob).hexdigest()[:16]
+
+    lines = []
+    for i in range(0, len(blob), 16):
+        lines.append("  " + ", ".join("0x%02x" % b for b in blob[i:i + 16]) + ",")
+
+    out = (
+        "#pragma once\n"
+        "// Automatisch generiert von scripts/embed_dashboard.py aus data/index.html – nicht editieren.\n"
+        "#include <pgmspace.h>\n"
+        "#include <stddef.h>\n"
+        "#include <stdint.h>\n\n"
+        "#define DASHBOARD_ETAG \"\\\"%s\\\"\"\n"
+        "static const size_t DASHBOARD_GZ_LEN = %d; // unkomprimiert: %d Byte\n"
+        "static const uint8_t DASHBOARD_GZ[] PROGMEM = {\n%s\n};\n"
+    ) % (etag, len(blob), len(html), "\n".join(lines))
+
+    # Nur schreiben, wenn sich etwas geändert hat (sonst unnötiger Rebuild)
+    if os.path.exists(DST):
+        with open(DST, "r") as f:
+            if f.read() == out:
+                return
+    with open(DST, "w") as f:
+        f.write(out)
+    print("embed_dashboard: %s → %d Byte gzip (ETag %s)" % (os.path.relpath(SRC, PROJECT_DIR), len(blob), etag))
+
+
+embed()
@@ -0,0 +1,292 @@
+#include "event_log.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "event_binary.h" // putLe16/putLe32
+
+static constexpr char SEG_DIR[] = "/ev";
+static constexpr int64_t RETENTION_SEC = 24 * 3600;
+static constexpr uint8_t SEG_VERSION = 2; // dt in ms (1: Sekunden, nur noch gelesen)
+
+static uint32_t getLe32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void EventLog::segPath(char* buf, size_t len, uint32_t no) {
+  snprintf(buf, len, "%s/s%08lx", SEG_DIR, (unsigned long)no);
+}
+
+bool EventLog::readHeader(const char* path, SegInfo& out) {
+  File f = fs_->open(path, FILE_READ);
+  if (!f) return false;
+  uint8_t h[HEADER_SIZE];
+  const size_t size = f.size();
+  const bool ok = f.read(h, sizeof(h)) == sizeof(h);
+  f.close();
+  if (!ok || memcmp(h, "LSEG", 4) != 0 || h[4] < 1 || h[4] > SEG_VERSION || h[5] != sizeof(PackedEvent)) return false;
+  out.version = h[4];
+  out.no = getLe32(h + 8);
+  out.firstSeq = getLe32(h + 12);
+  out.base = (int64_t)((uint64_t)getLe32(h + 16) | ((uint64_t)getLe32(h + 20) << 32));
+  out.records = (size - HEADER_SIZE) / sizeof(PackedEvent);
+  // Abgerissener Schreibvorgang (Reset mitten im Flush) → Segment nicht fortschreiben
+  if ((size - HEADER_SIZE) % sizeof(PackedEvent) != 0) out.records |= 0x80000000u;
+  return true;
+}
+
+bool EventLog::begin(fs::FS& fs) {
+  if (!ioMutex_) ioMutex_ = xSemaphoreCreateMutexStatic(&ioMutexBuf_);
+  fs_ = &fs;
+  segCount_ = 0;
+  if (!fs.exists(SEG_DIR) && !fs.mkdir(SEG_DIR)) return false;
+
+  File dir = fs.open(SEG_DIR);
+  if (!dir || !dir.isDirectory()) return false;
+
+  // Nur Header lesen; nach Segmentnummer einsortieren
+  for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+    char path[32];
+    snprintf(path, sizeof(path), "%s/%s", SEG_DIR, strrchr(f.name(), '/') ? strrchr(f.name(), '/') + 1 : f.name());
+    f.close();
+    SegInfo info;
+    if (!readHeader(path, info)) {
+      fs.remove(path); // kein gültiges Segment
+      continue;
+    }
+    if (segCount_ == MAX_SEGMENTS) {
+      // mehr als erwartet → das älteste verwerfen
+      if (info.no < segs_[0].no) { fs.remove(path); continue; }
+      dropOldest();
+    }
+    uint32_t i = segCount_++;
+    while (i > 0 && segs_[i - 1].no > info.no) { segs_[i] = segs_[i - 1]; --i; }
+    segs_[i] = info;
+  }
+
+  curWritable_ = false;
+  if (segCount_ > 0) {
+    SegInfo& last = segs_[segCount_ - 1];
+    curWritable_ = !(last.records & 0x80000000u) && last.records < SEG_RECORDS && last.version == SEG_VERSION;
+    last.records &= ~0x80000000u;
+  }
+  for (uint32_t i = 0; i + 1 < segCount_; ++i) segs_[i].records &= ~0x80000000u;
+  lastFlushMs_ = millis();
+  return true;
+}
+
+size_t EventLog::replay(time_t windowSec, ReplayFn fn, void* ctx) {
+  if (!fs_ || segCount_ == 0) return 0;
+
+  // Neuester Zeitstempel: letzter Eintrag im letzten nicht-leeren Segment
+  int64_t newest = 0;
+  for (uint32_t i = segCount_; i-- > 0; ) {
+    if (segs_[i].records == 0) continue;
+    char path[32];
+    segPath(path, sizeof(path), segs_[i].no);
+    File f = fs_->open(path, FILE_READ);
+    uint8_t rec[sizeof(PackedEvent)];
+    if (f && f.seek(HEADER_SIZE + (segs_[i].records - 1) * sizeof(PackedEvent)) && f.read(rec, sizeof(rec)) == sizeof(rec)) {
+      const uint32_t dt = getLe32(rec);
+      newest = segs_[i].base + (segs_[i].version == 1 ? dt : dt / 1000);
+    }
+    break;
+  }
+  const int64_t cutoff = newest - windowSec;
+
+  // Erstes Segment, das noch Einträge ≥ cutoff enthalten kann (Basis = erster Eintrag)
+  uint32_t start = 0;
+  for (uint32_t i = 0; i < segCount_; ++i) {
+    if (segs_[i].base <= cutoff) start = i;
+  }
+
+  size_t n = 0;
+  uint8_t buf[64 * sizeof(PackedEvent)];
+  for (uint32_t i = start; i < segCount_; ++i) {
+    const SegInfo& s = segs_[i];
+    char path[32];
+    segPath(path, sizeof(path), s.no);
+    File f = fs_->open(path, FILE_READ);
+    if (!f || !f.seek(HEADER_SIZE)) continue;
+    uint32_t k = 0;
+    while (k < s.records) {
+      const size_t want = std::min<size_t>(sizeof(buf), (s.records - k) * sizeof(PackedEvent));
+      const size_t got = f.read(buf, want) / sizeof(PackedEvent);
+      if (got == 0) break;
+      for (size_t j = 0; j < got; ++j, ++k) {
+        PackedEvent p;
+        p.dt = getLe32(buf + j * sizeof(PackedEvent));
+        p.bits = getLe32(buf + j * sizeof(PackedEvent) + 4);
+        LightningEvent e = unpackEvent(p, (time_t)s.base);
+        if (s.version == 1) { e.ts = (time_t)s.base + p.dt; e.ms = 0; }
+        if (e.ts >= cutoff) { fn(e, s.firstSeq + k, ctx); ++n; }
+      }
+    }
+  }
+  return n;
+}
+
+void EventLog::append(const LightningEvent& e, uint32_t seq) {
+  const PackedEvent p = packEvent(e, e.ts); // nur die Bits, dt kommt beim Schreiben dazu
+  bool wake = false;
+  portENTER_CRITICAL(&lock_);
+  Page& page = pages_[active_];
+  if (page.len < BATCH_MAX) {
+    page.items[page.len++] = {(int64_t)e.ts * 1000 + e.ms, p.bits, seq};
+    wake = page.len >= flushBatch_;
+  } else {
+    dropped_++;
+  }
+  portEXIT_CRITICAL(&lock_);
+  if (wake && task_) xTaskNotifyGive(task_);
+}
+
+uint32_t EventLog::nextSeq() const {
+  uint32_t next = 0;
+  for (uint32_t i = 0; i < segCount_; ++i) {
+    const uint32_t end = segs_[i].firstSeq + segs_[i].records;
+    if (!next || (int32_t)(end - next) > 0) next = end;
+  }
+  return next;
+}
+
+size_t EventLog::pending() const {
+  portENTER_CRITICAL(&lock_);
+  const size_t n = pages_[0].len + pages_[1].len;
+  portEXIT_CRITICAL(&lock_);
+  return n;
+}
+
+bool EventLog::startWriter(size_t batch, uint32_t intervalMs, UBaseType_t prio, uint32_t stack) {
+  if (batch > BATCH_MAX) batch = BATCH_MAX;
+  flushBatch_ = batch ? batch : 1;
+  flushIntervalMs_ = intervalMs;
+  if (task_) return true;
+  return xTaskCreate(writerTask, "evlog", stack, this, prio, &task_) == pdPASS;
+}
+
+void EventLog::writerTask(void* arg) {
+  EventLog* self = static_cast<EventLog*>(arg);
+  for (;;) {
+    // Geweckt von append() bei voller Seite, sonst nach Ablauf des Intervalls
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(self->flushIntervalMs_));
+    if (self->pending() > 0) self->flush();
+  }
+}
+
+void EventLog::dropOldest() {
+  if (segCount_ == 0) return;
+  char path[32];
+  segPath(path, sizeof(path), segs_[0].no);
+  fs_->remove(path);
+  memmove(segs_, segs_ + 1, (segCount_ - 1) * sizeof(SegInfo));
+  --segCount_;
+}
+
+bool EventLog::openNewSegment(const Item& first) {
+  // Aufbewahrung: Segmente, deren Nachfolger schon älter als 24h beginnt, sind komplett abgelaufen
+  while (segCount_ >= 2 && segs_[1].base < first.tsMs / 1000 - RETENTION_SEC) dropOldest();
+  if (segCount_ == MAX_SEGMENTS) dropOldest();
+
+  SegInfo info;
+  info.no = segCount_ ? segs_[segCount_ - 1].no + 1 : 1;
+  info.firstSeq = first.seq;
+  info.base = first.tsMs / 1000;
+  info.records = 0;
+  info.version = SEG_VERSION;
+
+  uint8_t h[HEADER_SIZE] = {0};
+  memcpy(h, "LSEG", 4);
+  h[4] = SEG_VERSION;
+  h[5] = sizeof(PackedEvent);
+  putLe16(h + 6, HEADER_SIZE);
+  putLe32(h + 8, info.no);
+  putLe32(h + 12, info.firstSeq);
+  putLe32(h + 16, (uint32_t)(uint64_t)info.base);
+  putLe32(h + 20, (uint32_t)((uint64_t)info.base >> 32));
+
+  char path[32];
+  segPath(path, sizeof(path), info.no);
+  File f = fs_->open(path, FILE_WRITE);
+  if (!f) return false;
+  const bool ok = f.write(h, sizeof(h)) == sizeof(h);
+  f.close();
+  if (!ok) return false;
+
+  segs_[segCount_++] = info;
+  curWritable_ = true;
+  return true;
+}
+
+// Schreibt n Einträge (fortlaufende seq) in Segmente; liefert die Anzahl geschriebener
+size_t EventLog::writeItems(const Item* items, size_t count) {
+  size_t done = 0;
+  while (done < count) {
+    const Item& first = items[done];
+    SegInfo* cur = segCount_ ? &segs_[segCount_ - 1] : nullptr;
+    // Neues Segment bei vollem Segment, Lücke in der seq oder Zeitsprung vor die Basis
+    if (!curWritable_ || !cur || cur->records >= SEG_RECORDS
+        || first.seq != cur->firstSeq + cur->records || first.tsMs < cur->base * 1000
+        || first.tsMs - cur->base * 1000 > (int64_t)UINT32_MAX) {
+      if (!openNewSegment(first)) break;
+      cur = &segs_[segCount_ - 1];
+    }
+
+    // Zusammenhängender Lauf, der in dieses Segment passt → ein einziger write()
+    uint8_t buf[BATCH_MAX * sizeof(PackedEvent)];
+    size_t n = 0;
+    while (done + n < count && cur->records + n < SEG_RECORDS) {
+      const Item& it = items[done + n];
+      const int64_t dt = it.tsMs - cur->base * 1000;
+      if (it.seq != cur->firstSeq + cur->records + n || dt < 0 || dt > (int64_t)UINT32_MAX) break;
+      putLe32(buf + n * sizeof(PackedEvent), (uint32_t)dt);
+      putLe32(buf + n * sizeof(PackedEvent) + 4, it.bits);
+      ++n;
+    }
+
+    char path[32];
+    segPath(path, sizeof(path), cur->no);
+    File f = fs_->open(path, FILE_APPEND);
+    const size_t bytes = n * sizeof(PackedEvent);
+    const bool ok = f && f.write(buf, bytes) == bytes;
+    if (f) f.close();
+    if (!ok) {
+      curWritable_ = false; // Segment evtl. beschädigt → beim nächsten Versuch neues anfangen
+      break;
+    }
+    cur->records += n;
+    if (cur->records >= SEG_RECORDS) curWritable_ = false;
+    done += n;
+  }
+  return done;
+}
+
+// Schreibt die Seite des Schreibers; nicht Geschriebenes bleibt für den nächsten Versuch liegen
+bool EventLog::writeSpare() {
+  Page& spare = pages_[active_ ^ 1];
+  if (spare.len == 0) return true;
+  const size_t done = writeItems(spare.items, spare.len);
+  if (done) {
+    memmove(spare.items, spare.items + done, (spare.len - done) * sizeof(Item));
+    spare.len -= done;
+  }
+  if (spare.len) writeErrors_++;
+  return spare.len == 0;
+}
+
+bool EventLog::flush(uint32_t waitMs) {
+  if (!fs_ || !ioMutex_) return false;
+  if (xSemaphoreTake(ioMutex_, pdMS_TO_TICKS(waitMs)) != pdTRUE) return false;
+
+  // Erst Reste eines fehlgeschlagenen Versuchs (älter), dann die aktuelle Seite
+  bool ok = writeSpare();
+  if (ok) {
+    portENTER_CRITICAL(&lock_);
+    active_ ^= 1; // append() sammelt ab jetzt in der leeren Seite weiter
+    portEXIT_CRITICAL(&lock_);
+    ok = writeSpare();
+  }
+  lastFlushMs_ = millis();
+  xSemaphoreGive(ioMutex_);
+  return ok;
+}
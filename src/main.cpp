@@ -25,8 +25,8 @@ Library: https://github.com/sparkfun/SparkFun_AS3935_Lightning_Detector_Arduino_
 
 ## Hinweise & Tuning
 
-- **Indoor/Outdoor:** `setIndoor(true)` für drinnen, `false` für draußen (empfohlen bei Outdoor-Montage).
-- **Filter:** `setNoiseFloor`, `setSpikeRejection`, `setWatchdogThreshold` an deine Umgebung anpassen, sonst gibt’s viele Fehlalarme.
+- **Indoor/Outdoor:** `indoor=true` für drinnen, `false` für draußen (empfohlen bei Outdoor-Montage), über `/api/config`.
+- **Filter:** `noise_level`, `spike_rejection`, `watchdog` (ebenfalls `/api/config`) an deine Umgebung anpassen, sonst gibt’s viele Fehlalarme.
 - **Distanz-Buckets & LEDs:** aktuell: ≤5 km (alle LEDs), 6–10 km (3 LEDs), 11–20 km (2 LEDs), >20 km (1 LED), 63 km (aus). Feinjustiere nach Bedarf.
 - **Zeiten:** Die History hält max. 24 h. Über `/api/events?since=86400` bekommst du 24 h.
 - **Sicherheit:** `secrets.h` nicht in Repos einchecken. Für produktive Nutzung gern „WiFiManager“ nutzen.
@@ -37,21 +37,84 @@ Library: https://github.com/sparkfun/SparkFun_AS3935_Lightning_Detector_Arduino_
 #include <Arduino.h>
 #include <WiFi.h>
 #include <esp_wifi.h>
+#include <esp_sntp.h>
+#include <esp_system.h>
+#include <esp_cpu.h>
+#include <esp_heap_caps.h>
+#include <soc/gpio_reg.h>
+#ifdef LOW_POWER
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#endif
+#ifdef USE_ASYNC_WEBSERVER
+#include <ESPAsyncWebServer.h>
+#else
 #include <WebServer.h>
+#endif
 #include <ArduinoJson.h>
 #include <SparkFun_AS3935.h> // SparkFun AS3935 Lightning Detector
 #include <Wire.h>
 #include <vector>
-#include <deque>
 #include <algorithm>
 #include <time.h>
+#include <memory>
+#include <LittleFS.h>
+#include <AsyncUDP.h>
+#include <mqtt_client.h>
+#include <Preferences.h>
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <esp_task_wdt.h>
 
 #include "secrets.h"
+#include "event_store.h"
+#include "event_json.h"
+#include "event_binary.h"
+#include "stats_aggregate.h"
+#include "spsc_queue.h"
+#include "event_log.h"
+#include "metrics.h"
+#include "led_map.h"
+#include "storm_trend.h"
+#include "interference.h"
+#include "irq_storm.h"
+#include "event_clock.h"
+#include "strike_packet.h"
+#include "mqtt_outbox.h"
+#include "device_config.h"
+#include "as3935_burst.h"
+#include "ota_health.h"
+#include "supervisor.h"
+#include "event_pipeline.h"
+#include "dashboard_gz.h" // generiert beim Build aus data/index.html
 
 // Aktiviere (Define) für Debugging mit der seriellen Schnittstelle
 //#define SERIALDEBUG
 
+// Aktiviere (Define), um die automatische Nachführung von Noise-Level/Watchdog/Spike-Rejection
+// bei vielen Störern abzuschalten (dann gelten immer die Ausgangswerte aus /api/config)
+//#define AFE_NO_AUTOTUNE
+
+// Aktiviere (Define) für Batterie-/Solarbetrieb: automatischer Light Sleep zwischen den
+// Interrupts (Wecken über PIN_AS3935_IRQ), WLAN-Modem-Sleep (DTIM) solange kein Stream-Client
+// verbunden ist, loop() wartet statt zu drehen. Voraussetzungen siehe readme.
+//#define LOW_POWER
+
+// Aktiviere (Define), damit die LEDs bei hoher Blitzrate blinken (schneller je mehr Blitze)
+//#define LED_BLINK_BY_RATE
+
+// Aktiviere (Define), damit jeder neue Blitz per UDP-Multicast an Nachbarknoten und Collector
+// geht (Format: strike_packet.h); die LEDs zeigen dann auch das nächste Gewitter der Nachbarn
+//#define STRIKE_BROADCAST
+
+// Build-Option USE_ASYNC_WEBSERVER (siehe env:esp32-c3-devkitm-1-async in platformio.ini):
+// ereignisgesteuerter AsyncWebServer statt synchronem WebServer → mehrere Clients parallel,
+// loop() blockiert nicht mehr in handleClient().
+
 // Eventmaske: 0b1000 = BLitz, 0b0100 = Störer, 0b0001 = Noise too high
+// (Vorgabe, zur Laufzeit über /api/config änderbar)
 #define EVENT_MASK 0b1000
 
 // =============================
@@ -69,128 +132,722 @@ static constexpr int LED1 = 3;   // sehr nahe (≤5 km)
 static constexpr int LED2 = 4;   // nahe (6–10 km)
 static constexpr int LED3 = 5;   // mittel (11–20 km)
 static constexpr int LED4 = 1;   // weit (>20 km)  (vermeide 0/2/8/9 wegen Boot/Straps, falls möglich)  // weit (>20 km)
+static_assert(LED1 < 32 && LED2 < 32 && LED3 < 32 && LED4 < 32, "LEDs muessen im GPIO_OUT_REG liegen");
+
+// LED-Muster → Bits im GPIO-Ausgangsregister (Distanz → Muster: LED_LUT aus led_map.h)
+static constexpr LedGpioLut LED_GPIO = makeLedGpioLut(LED1, LED2, LED3, LED4);
+
+#ifdef LOW_POWER
+// Wartezeit am Ende von loop(): der synchrone WebServer muss gepollt werden, der asynchrone
+// nicht (loop() wird bei neuen Messungen ohnehin per Notification geweckt)
+#ifdef USE_ASYNC_WEBSERVER
+static constexpr uint32_t LOOP_IDLE_MS = 1000;
+#else
+static constexpr uint32_t LOOP_IDLE_MS = 50;
+#endif
+static constexpr int PM_MIN_FREQ_MHZ = 40;        // XTAL, Minimum für WLAN
+static constexpr uint32_t HTTP_IDLE_MS = 10000;   // ohne Anfragen so lange → Modem-Sleep
+#endif
+
+#ifdef STRIKE_BROADCAST
+// Multicast-Gruppe und Port (per Build-Flag änderbar, z. B. -DSTRIKE_PORT=5000)
+#ifndef STRIKE_GROUP
+#define STRIKE_GROUP 239, 255, 43, 35
+#endif
+#ifndef STRIKE_PORT
+#define STRIKE_PORT 43535
+#endif
+static constexpr uint32_t STRIKE_BATCH_MS = 20;   // Blitze innerhalb dieser Zeit → ein Datagramm
+static constexpr uint32_t PEER_MAX_AGE_SEC = 900; // so lange zählt der letzte Blitz eines Nachbarn
+static constexpr size_t PEER_MAX = 16;
+#endif
+
+// MQTT: aktiv, sobald secrets.h MQTT_URI definiert (siehe secrets.example.h)
+#ifdef MQTT_URI
+#ifndef MQTT_TOPIC
+#define MQTT_TOPIC "lightning"
+#endif
+#ifndef MQTT_MAX_PER_SEC
+#define MQTT_MAX_PER_SEC 5
+#endif
+static constexpr uint32_t MQTT_BURST = 20;                // so viele Blitze gehen ohne Drosselung sofort raus
+static constexpr uint32_t MQTT_QUEUE_MAX = 1024;          // höchstens so viele verpasste Blitze nachschicken
+static constexpr uint32_t MQTT_STATE_INTERVAL_MS = 60000; // live/trend spätestens alle 60 s …
+static constexpr uint32_t MQTT_STATE_MIN_MS = 2000;       // … und bei Änderungen höchstens alle 2 s
+#endif
+
+// OTA-Update über /api/ota: aktiv, sobald secrets.h OTA_PASSWORD definiert (HTTP Basic Auth)
+#ifdef OTA_PASSWORD
+#ifndef OTA_USER
+#define OTA_USER "ota"
+#endif
+static constexpr uint32_t OTA_RESTART_DELAY_MS = 500;  // Antwort noch senden, dann neu starten
+#endif
+// Nach einem Update: so lange ununterbrochen gesund → Image bestätigen, sonst nach
+// OTA_VERIFY_TIMEOUT_MS zurück zum alten (ota_health.h)
+static constexpr uint32_t OTA_HEALTHY_HOLD_MS = 30000;
+static constexpr uint32_t OTA_VERIFY_TIMEOUT_MS = 180000;
+
+#ifdef LED_BLINK_BY_RATE
+static constexpr uint32_t LED_BLINK_MIN_RATE = 10; // Blitze/min (Mittel über 5 min), ab denen geblinkt wird
+#endif
+
+// Ausgangswerte des AS3935-Analogteils (Vorgabe, zur Laufzeit über /api/config änderbar); die
+// Nachführung (interference.h) senkt bei vielen Störern die Empfindlichkeit und kehrt danach
+// hierher zurück
+static constexpr AfeSettings AFE_BASE = {
+  2,     // setNoiseLevel 1..7 (höher = weniger empfindlich ggü. Rauschen)
+  2,     // watchdogThreshold 1..10
+  2,     // spikeRejection 1..11 (höher = robust, evtl. weniger empfindlich)
+  false  // maskDisturber: false = Störer melden (werden gezählt, nicht gespeichert)
+};
 
 // I2C-Adresse des AS3935 (SparkFun Breakout meist 0x03, als 7-bit = 0x03 / Library intern handled)
 // Die SparkFun-Lib erwartet die 7-bit Adresse (Default 0x03). Manche Breakouts nutzen 0x02/0x03 (gelötet). Bei Problemen prüfen!
 static constexpr uint8_t AS3935_I2C_ADDR = 0x03;
 
+// I2C-Takt (Fast Mode); bei langen Leitungen oder schwachen Pull-ups z. B. -DAS3935_I2C_HZ=100000
+#ifndef AS3935_I2C_HZ
+#define AS3935_I2C_HZ 400000
+#endif
+
 // =============================
 // Globale Objekte
 // =============================
 SparkFun_AS3935 lightning(AS3935_I2C_ADDR);
+#ifdef USE_ASYNC_WEBSERVER
+AsyncWebServer server(80);
+using HttpRequest = AsyncWebServerRequest;
+#else
 WebServer server(80);
-volatile bool irqFlag = false; // vom ISR gesetzt
-static uint32_t tLastPoll = 0;
+using HttpRequest = WebServer; // synchron: der Server selbst steht für die aktuelle Anfrage
+#endif
+
+// Sensor-Task: wird vom ISR per Task-Notification geweckt und liest den AS3935 aus,
+// unabhängig davon, wie lange loop() gerade in server.handleClient() hängt.
+static constexpr uint32_t SENSOR_TASK_STACK = 4096;
+static constexpr UBaseType_t SENSOR_TASK_PRIO = 10; // über loopTask (1), unter WiFi
+static constexpr uint32_t NOTIFY_IRQ = 1u << 0;
+static constexpr uint32_t NOTIFY_CONFIG = 1u << 1; // neue Konfiguration übernehmen
+static constexpr uint32_t NOTIFY_CHECK = 1u << 2;  // Supervisor: Register prüfen, ggf. neu initialisieren
+static constexpr uint32_t POLL_INTERVAL_MS = 10000; // Vorgabe für config.pollMs
+static TaskHandle_t sensorTaskHandle = nullptr;
+static TaskHandle_t loopTaskHandle = nullptr; // Sensor-Task weckt loop(), wenn etwas in der Queue liegt
+#ifdef LOW_POWER
+static esp_pm_lock_handle_t sensorPmLock = nullptr; // volle CPU-Frequenz, kein Light Sleep beim Lesen
+static uint32_t lastRequestMs = 0;
+#endif
+
+// Supervisor-Task (Selbstheilung, supervisor.h): prüft Herzschläge, AS3935, WLAN und Heap und
+// füttert den Task-Watchdog. Heap-Schwellen per Build-Flag änderbar.
+#ifndef HEAP_RESTART_FREE_BYTES
+#define HEAP_RESTART_FREE_BYTES 16384
+#endif
+// Größter Block: die größte Einzelallokation im Betrieb plus 2 KB Reserve (Header, pbufs).
+// Das ist der Sendepuffer eines Antwort-Chunks im Async-Build (bis TCP_SND_BUF, lwIP-Default
+// 5744 B); kleiner sind der Antwort-String von /api/series (≈ 3 KB, 120 Bins × 4 Reihen) und
+// der MetricsStream von /api/metrics (METRICS_CHUNK_MAX, siehe handleMetrics).
+#ifndef HEAP_RESTART_BLOCK_BYTES
+#ifdef CONFIG_LWIP_TCP_SND_BUF_DEFAULT
+#define HEAP_RESTART_BLOCK_BYTES (CONFIG_LWIP_TCP_SND_BUF_DEFAULT + 2048)
+#else
+#define HEAP_RESTART_BLOCK_BYTES (5744 + 2048)
+#endif
+#endif
+static constexpr uint32_t SUPERVISOR_STACK = 6144;      // esp_restart() schreibt das Log auf diesem Stack
+static constexpr UBaseType_t SUPERVISOR_PRIO = 2;       // über loopTask, unter dem Sensor-Task
+static constexpr uint32_t SUPERVISOR_PERIOD_MS = 1000;
+static constexpr uint32_t SUPERVISOR_WDT_MS = 10000;    // nur falls Arduino den Task-Watchdog nicht startet
+static constexpr uint32_t TASK_STALL_MS = 60000;        // kein Herzschlag so lange → Neustart
+static constexpr uint32_t SENSOR_CHECK_MS = 30000;      // Register des AS3935 so oft gegenprüfen
+static constexpr uint32_t SENSOR_CHECK_FAILS = 2;       // in Folge falsch → Bus freitakten, neu initialisieren
+static constexpr uint32_t HEAP_LOW_CHECKS = 30;         // 30 s in Folge zu wenig Heap → Neustart
+static constexpr uint32_t WIFI_RETRY_MIN_MS = 5000;     // WLAN-Backoff 5 s, 10 s, … bis 2 min
+static constexpr uint32_t WIFI_RETRY_MAX_MS = 120000;
+
+// IRQ-Sturmschutz: über IRQ_STORM_MAX_PER_SEC Flanken/s wird das Lesen gedrosselt und der
+// Disturber maskiert, bis die Rate IRQ_STORM_HOLD_MS lang deutlich darunter lag (irq_storm.h)
+#ifndef IRQ_STORM_MAX_PER_SEC
+#define IRQ_STORM_MAX_PER_SEC 20
+#endif
+#ifndef IRQ_STORM_HOLD_MS
+#define IRQ_STORM_HOLD_MS 60000
+#endif
+static IrqStormGuard irqGuard(IRQ_STORM_MAX_PER_SEC, IRQ_STORM_HOLD_MS); // nur im Sensor-Task
+static volatile uint32_t isrEdges = 0; // Flanken am IRQ-Pin, vom ISR gezählt
+
+// Übergabe Sensor-Task → loop() (ein Schreiber, ein Leser)
+static SpscQueue<LightningEvent, 64> sensorQueue;
+static volatile uint32_t sensorQueueDrops = 0; // verworfen, weil loop() nicht nachkam
 
 // =============================
 // Datenstrukturen
 // =============================
-struct LightningEvent {
-  time_t ts;        // Unix Timestamp (UTC)
-  uint8_t distance; // 1..63 km (63 = out of range laut Datenblatt), 0 = Sturm sehr nahe / über Kopf
-  uint32_t energy;  // „Energy“ Rohwert aus dem Sensor (nicht kalibriert)
-  uint32_t event;
-  bool irq;
+// LightningEvent und das gepackte 8-Byte-Format: siehe event_store.h
+
+// Ereignisliste (8192 gepackte Einträge = 64 KB ≈ 24h auch bei starker Gewitterfront)
+// Statischer Ringpuffer statt std::deque → kein Heap-Verbrauch, keine Fragmentierung.
+// Kapazität muss eine Zweierpotenz sein; beim Überlauf fällt der älteste Eintrag heraus.
+// Zur Laufzeit lässt sich nur darunter begrenzen (config.historyMax).
+static constexpr size_t HISTORY_MAX = 8192;
+static EventStore<HISTORY_MAX> history;
+
+// =============================
+// Laufzeit-Konfiguration (/api/config)
+// =============================
+// Vorgaben, solange im NVS nichts (Gültiges) steht. Ein Schlüssel pro Feld im Namespace
+// CONFIG_NVS_NAMESPACE, geschrieben werden nur geänderte Felder.
+static constexpr uint32_t RESET_TIMEOUT_SEC = 10 * 60; // Live-Werte 10 min nach dem letzten Blitz zurücksetzen
+static constexpr DeviceConfig CONFIG_DEFAULT = {
+  true,        // Indoor-Modus (weniger Rauschen)
+  AFE_BASE,
+  EVENT_MASK,
+  HISTORY_MAX,
+  RESET_TIMEOUT_SEC,
+  POLL_INTERVAL_MS
+};
+static_assert(validateConfig(CONFIG_DEFAULT, HISTORY_MAX) == nullptr, "CONFIG_DEFAULT ausserhalb der Grenzen");
+static constexpr const char* CONFIG_NVS_NAMESPACE = "config";
+
+// Geschrieben vom /api/config-Handler, gelesen als Kopie (configSnapshot); der Sensor-Task
+// übernimmt Änderungen erst auf NOTIFY_CONFIG
+static DeviceConfig config = CONFIG_DEFAULT;
+static portMUX_TYPE configMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t configChanges = 0;
+static uint32_t afeRegisterWrites = 0; // I2C-Schreibzugriffe auf 0x00..0x03 (nur Sensor-Task)
+
+static DeviceConfig configSnapshot() {
+  portENTER_CRITICAL(&configMux);
+  const DeviceConfig c = config;
+  portEXIT_CRITICAL(&configMux);
+  return c;
+}
+
+// Minuten-Aggregate für /api/stats (werden beim Einfügen/Trimmen mitgeführt)
+static MinuteAggregates stats;
+
+// Distanz-Nachlesungen config.pollMs nach einem Blitz (/api/samples); die History enthält
+// damit genau einen Eintrag pro Blitz
+static constexpr size_t SAMPLES_MAX = 32;
+static RingBuffer<DistanceSample, SAMPLES_MAX> samples;
+
+// Persistente Kopie der History im Flash (LittleFS), beim Booten zurückgespielt
+static EventLog eventLog;
+
+#ifdef STRIKE_BROADCAST
+// Push an Nachbarknoten und Collector: gesendet wird aus loop(), empfangen im AsyncUDP-Task
+static AsyncUDP strikeUdp;
+static StrikeBatch strikeBatch; // nur loop()
+static uint32_t nodeId = 0;     // nodeIdFromMac(): MAC-Bytes 3..5 + gefaltete OUI
+static PeerTable<PEER_MAX> peers;
+static portMUX_TYPE peerMux = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t strikePacketsSent = 0;
+static uint32_t strikeSendErrors = 0;     // ohne WLAN oder writeTo fehlgeschlagen
+static volatile uint32_t strikePacketsReceived = 0;
+static volatile uint32_t strikePacketsInvalid = 0;
+#endif
+
+#ifdef MQTT_URI
+// MQTT-Client und Cursor über die History (Ablauf siehe mqttLoop)
+struct MqttAck {
+  int msgId;
+  bool ok; // false = aus der Client-Outbox verworfen
 };
 
-// Ereignisliste (max ~ 2000 Einträge ≈ ausreichend für 24h bei moderater Aktivität)
-static std::deque<LightningEvent> history;
-static const size_t HISTORY_MAX = 2000;
+static esp_mqtt_client_handle_t mqtt = nullptr;
+static volatile bool mqttConnected = false;
+static volatile uint32_t mqttSessions = 0;  // CONNECTED-Zähler
+static SpscQueue<MqttAck, 32> mqttAcks;     // MQTT-Task → loop()
+static PublishCursor mqttCursor;            // nur loop()
+static RateLimiter mqttRate(MQTT_MAX_PER_SEC, MQTT_BURST);
+static uint32_t mqttEnqueueErrors = 0;
+
+// Bestätigte seq überlebt Softresets: danach geht es ohne Lücke weiter, doppelt kommen
+// höchstens die beim Reset unbestätigten Blitze (Empfänger deduplizieren über seq)
+struct MqttResume {
+  uint32_t magic;
+  uint32_t ackedSeq;
+};
+static constexpr uint32_t MQTT_RESUME_MAGIC = 0x4D515431; // "MQT1"
+RTC_NOINIT_ATTR static MqttResume mqttResume;
+#endif
+// Geschrieben wird von einem eigenen Task (write-behind), nie aus loop() oder dem Sensor-Task.
+// Batchgröße (max. EventLog::BATCH_MAX) und Intervall per Build-Flag überschreibbar. Das
+// Intervall ist zugleich das größte Alter eines Eintrags, der nur im RAM liegt – also das
+// Verlustfenster bei Stromausfall und Brownout, für die es keinen Hook gibt (der Brownout-
+// Detektor setzt den Chip direkt zurück). Geschrieben wird nur, wenn etwas ansteht.
+#ifndef EVENTLOG_FLUSH_BATCH
+#define EVENTLOG_FLUSH_BATCH 32
+#endif
+#ifndef EVENTLOG_FLUSH_INTERVAL_MS
+#define EVENTLOG_FLUSH_INTERVAL_MS 10000
+#endif
+// Nach einem Brownout-Reset ist die Versorgung oft weiter schwach: dann kürzer
+#ifndef EVENTLOG_FLUSH_INTERVAL_BROWNOUT_MS
+#define EVENTLOG_FLUSH_INTERVAL_BROWNOUT_MS 1000
+#endif
+static constexpr size_t LOG_FLUSH_BATCH = EVENTLOG_FLUSH_BATCH;            // Einträge pro Schreibvorgang
+static constexpr uint32_t LOG_FLUSH_INTERVAL_MS = EVENTLOG_FLUSH_INTERVAL_MS; // spätestens dann schreiben
+static constexpr uint32_t LOG_FLUSH_INTERVAL_BROWNOUT_MS = EVENTLOG_FLUSH_INTERVAL_BROWNOUT_MS;
+static constexpr UBaseType_t LOG_TASK_PRIO = 1; // wie loopTask (Zeitscheiben), weit unter dem Sensor-Task
+static constexpr uint32_t LOG_REBOOT_FLUSH_MS = 2000; // geplanter Neustart: so lange auf den Schreib-Task warten
+
+// Vor einem geplanten Neustart (OTA, Rollback, Supervisor): Staging-Seiten schreiben und dafür
+// auf einen laufenden Schreibvorgang warten – eine Seite dauert nur ms. Der Shutdown-Handler
+// (flushLogOnShutdown) wartet nicht und findet danach meist nichts mehr vor.
+static void flushLogBeforeReboot() {
+  const bool ok = eventLog.flush(LOG_REBOOT_FLUSH_MS);
+#ifdef SERIALDEBUG
+  if (!ok) Serial.printf("History: %u Eintraege vor dem Neustart nicht geschrieben\n", (unsigned)eventLog.pending());
+#else
+  (void)ok;
+#endif
+}
+
+// Zuletzt vergebene seq, überlebt Softresets und Watchdog (nicht Stromausfall): auch verworfene
+// oder nie geschriebene Einträge behalten ihre Nummer, siehe restoreHistory()
+struct SeqResume {
+  uint32_t magic;
+  uint32_t headSeq;
+};
+static constexpr uint32_t SEQ_RESUME_MAGIC = 0x53455131; // "SEQ1"
+RTC_NOINIT_ATTR static SeqResume seqResume;
+
+// Gewitter-Trend (Rate, Annäherung, Warnstufe) – fortgeschrieben im Sensor-Task, O(1) pro Blitz.
+// Kurze kritische Sektion statt Mutex: der Sensor-Task soll nie auf einen HTTP-Handler warten.
+static StormTrend trend;
+static portMUX_TYPE trendMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Uhrzeit: Blitze werden im ISR mit esp_timer_get_time() (µs seit Boot) gestempelt, die
+// Wanduhr steckt nur im NTP-Offset von eventClock (siehe event_clock.h). Der Sensor läuft
+// sofort nach dem Booten, NTP kommt erst mit dem WLAN: bis dahin tragen Ereignisse Zeit seit
+// Boot und werden nach der ersten Synchronisation über monoUs auf Unix-Zeit umgerechnet.
+// Nach einem Softreset läuft die RTC-Uhr weiter.
+static constexpr time_t TIME_VALID_MIN = 1600000000; // darunter: Sekunden seit Boot
+static EventClock eventClock;
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool clockValid = false; // = eventClock.synced(), ohne Lock lesbar
+
+static inline bool isUnixTime(time_t t) { return t >= TIME_VALID_MIN; }
+
+static inline void setEventTime(LightningEvent& e, int64_t us) {
+  e.ts = usToSec(us);
+  e.ms = usToMs(us);
+}
+
+// Zeitstempel für ein Ereignis zum Zeitpunkt monoUs (nie fallend, siehe EventClock::stamp)
+static int64_t stampUs(int64_t monoUs) {
+  portENTER_CRITICAL(&clockMux);
+  const int64_t t = eventClock.stamp(monoUs);
+  portEXIT_CRITICAL(&clockMux);
+  return t;
+}
+
+// Umrechnung ohne Monotonie-Klammer (zurückgehaltene Ereignisse, Abfragen)
+static int64_t clockAtUs(int64_t monoUs) {
+  portENTER_CRITICAL(&clockMux);
+  const int64_t t = eventClock.now(monoUs);
+  portEXIT_CRITICAL(&clockMux);
+  return t;
+}
 
-// Poll-Status
-static uint8_t lastDistance = 63;  // zuletzt gemeldete Distanz (km)
-static uint32_t lastEnergy = 0;    // zuletzt gemeldete Energie (keine pyhsikalische Bedeutung)
-static time_t lastEventTs = 0;
-static uint8_t lastEvent = 0;
+static time_t eventNow() { return usToSec(clockAtUs(esp_timer_get_time())); }
+
+static time_t clockOffsetSec() {
+  portENTER_CRITICAL(&clockMux);
+  const int64_t off = eventClock.offsetUs();
+  portEXIT_CRITICAL(&clockMux);
+  return usToSec(off);
+}
+
+static TrendSnapshot trendSnapshot(time_t now) {
+  portENTER_CRITICAL(&trendMux);
+  const TrendSnapshot t = trend.snapshot(now);
+  portEXIT_CRITICAL(&trendMux);
+  return t;
+}
+
+// Noise-/Disturber-Interrupts: eigene Zähler, nie in der History. Geschrieben nur vom Sensor-Task
+// (der auch die Nachführung ausführt und als einziger I2C spricht), gelesen von den Handlern.
+static InterferenceStats interference;
+static AfeAutoTuner afeTuner(AFE_BASE);
+static portMUX_TYPE interferenceMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Schützt history, stats und samples: loop() schreibt, Async-Handler lesen aus dem async_tcp-Task
+static StaticSemaphore_t historyMutexBuf;
+static SemaphoreHandle_t historyMutex = nullptr;
+struct HistoryLock {
+  HistoryLock() { xSemaphoreTake(historyMutex, portMAX_DELAY); }
+  ~HistoryLock() { xSemaphoreGive(historyMutex); }
+};
+
+// =============================
+// Metriken (/api/metrics)
+// =============================
+// Zeitmessung über den CPU-Zykluszähler (wraps nach ~26 s bei 160 MHz – für Dauern egal)
+static uint32_t cpuMhz = 160;
+static inline uint32_t cyclesToUs(uint32_t cycles) { return cycles / cpuMhz; }
+
+struct ScopeTimer {
+  explicit ScopeTimer(LatencyHistogram& h) : h_(h), t0_(esp_cpu_get_ccount()) {}
+  ~ScopeTimer() { h_.observe(cyclesToUs(esp_cpu_get_ccount() - t0_)); }
+  LatencyHistogram& h_;
+  uint32_t t0_;
+};
+
+static volatile uint32_t isrCycles = 0;   // Zeitpunkt des letzten AS3935-Interrupts
+// esp_timer_get_time() der ersten Flanke seit dem letzten Lesen (64 Bit: nur unter isrMux)
+static int64_t isrTimeUs = 0;
+static bool isrTimePending = false;
+static portMUX_TYPE isrMux = portMUX_INITIALIZER_UNLOCKED;
+static LatencyHistogram mIsrToRead;       // ISR → Beginn readInterruptReg (inkl. 2 ms Pflichtwartezeit)
+static LatencyHistogram mI2cBurst;       // 0x03..0x07 nach einem Interrupt
+static LatencyHistogram mI2cPoll;        // 0x04..0x07 bei der Nachlesung
+static uint32_t i2cErrors = 0;            // fehlgeschlagene Burst-Lesevorgänge (nur Sensor-Task)
+static LatencyHistogram mLoop;            // ein loop()-Durchlauf
+static LatencyHistogram mJsonLive;        // serializeJson /api/live
+static LatencyHistogram mJsonStats;       // serializeJson /api/stats
+static LatencyHistogram mJsonStrike;      // formatEventJson für den Stream
+static uint32_t wifiDisconnects = 0;
+static uint32_t wifiReconnects = 0;       // GOT_IP nach einem Verbindungsabbruch
+
+// Pro registrierter Route ein Histogramm (siehe route())
+static constexpr size_t MAX_ROUTES = 16;
+struct RouteStat {
+  const char* uri;
+  LatencyHistogram h;
+};
+static RouteStat routeStats[MAX_ROUTES];
+static size_t routeCount = 0;
+
+// Supervisor: Herzschläge (von den Tasks hochgezählt) und Zähler
+static volatile uint32_t sensorBeat = 0;  // pro Durchlauf des Sensor-Tasks
+static volatile uint32_t loopBeat = 0;    // pro Leeren der Sensor-Queue (auch während eines OTA-Uploads)
+static uint32_t sensorCheckFailures = 0;  // Registerprüfung fehlgeschlagen (nur Sensor-Task)
+static uint32_t sensorRecoveries = 0;     // Bus freigetaktet und AS3935 neu initialisiert
+static bool taskWdtActive = false;
+static RetryBackoff wifiBackoff(WIFI_RETRY_MIN_MS, WIFI_RETRY_MAX_MS);
+static portMUX_TYPE wifiMux = portMUX_INITIALIZER_UNLOCKED; // wifiBackoff: WiFi-Event-Task ↔ Supervisor
+
+// Kontrollierte Neustarts nach Grund, überleben den Softreset im RTC-RAM
+enum RestartReason : uint8_t { RESTART_HEAP, RESTART_SENSOR_STALL, RESTART_LOOP_STALL, RESTART_REASONS };
+static const char* const RESTART_REASON_LABELS[RESTART_REASONS] = {
+  "reason=\"heap\"", "reason=\"sensor_stall\"", "reason=\"loop_stall\""
+};
+struct RestartLog {
+  uint32_t magic;
+  uint32_t count[RESTART_REASONS];
+};
+static constexpr uint32_t RESTART_LOG_MAGIC = 0x53555031; // "SUP1"
+RTC_NOINIT_ATTR static RestartLog restartLog;
+
+// OTA: Upload im Handler (async: async_tcp-Task), Neustart und Prüfung in loop()
+static OtaHealthCheck otaHealth(OTA_HEALTHY_HOLD_MS, OTA_VERIFY_TIMEOUT_MS);
+#ifdef OTA_PASSWORD
+static HttpRequest* otaOwner = nullptr;    // Anfrage, deren Upload gerade geschrieben wird (nur eine)
+static HttpRequest* otaFinished = nullptr; // Anfrage, deren Upload zuletzt abgeschlossen wurde
+static uint32_t otaBytes = 0;              // geschrieben im laufenden bzw. letzten Upload
+static uint32_t otaFailures = 0;
+static volatile uint32_t otaRestartAtMs = 0; // 0 = kein Neustart geplant
+static String otaError;
+#endif
+
+// Poll-Status (Live-Werte stehen in pipeline, siehe event_pipeline.h). loop() und Sensor-Task
+// schreiben, /api/live liest im Async-Build aus dem async_tcp-Task: deshalb unter liveMux.
+static portMUX_TYPE liveMux = portMUX_INITIALIZER_UNLOCKED;
 static bool AS3935_started = false; // Flag ob der Sensor gesartet ist
-static bool AS3935_irq = false;     // Flag der IRQ getriggert wurde
 
 // =============================
 // Hilfsfunktionen
 // =============================
-void IRAM_ATTR onAs3935Interrupt() { irqFlag = true; }
+void IRAM_ATTR onAs3935Interrupt() {
+  BaseType_t woken = pdFALSE;
+  isrCycles = esp_cpu_get_ccount();
+  isrEdges = isrEdges + 1;
+  portENTER_CRITICAL_ISR(&isrMux);
+  if (!isrTimePending) {
+    isrTimeUs = esp_timer_get_time();
+    isrTimePending = true;
+  }
+  portEXIT_CRITICAL_ISR(&isrMux);
+#ifdef LOW_POWER
+  // Wecken aus dem Light Sleep geht nur per Pegel-Interrupt: bis zum Lesen des Registers aus,
+  // sonst feuert der ISR ununterbrochen (der IRQ-Pin bleibt bis dahin high)
+  gpio_ll_set_intr_type(&GPIO, (gpio_num_t)PIN_AS3935_IRQ, GPIO_INTR_DISABLE);
+#endif
+  if (sensorTaskHandle) xTaskNotifyFromISR(sensorTaskHandle, NOTIFY_IRQ, eSetBits, &woken);
+  portYIELD_FROM_ISR(woken);
+}
 
 static String tsToIso8601(time_t t) {
-  struct tm timeinfo;
-  gmtime_r(&t, &timeinfo);
   char buf[32];
-  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &timeinfo);
+  formatIso8601(buf, sizeof(buf), t);
   return String(buf);
 }
 
-static void trimHistoryOlderThan(time_t cutoff) {
-  while (!history.empty() && history.front().ts < cutoff) {
-    history.pop_front();
+
+
+// =============================
+// Push-Kanal (Server-Sent Events auf /api/stream)
+// =============================
+// Pro neuem Ereignis ein "strike"-Frame, pro LED-Wechsel ein "led"-Frame. Das Dashboard lädt
+// die letzte Stunde nur noch einmal und schreibt sie danach aus dem Stream fort.
+#ifdef USE_ASYNC_WEBSERVER
+static AsyncEventSource sse("/api/stream");
+#else
+// Synchroner WebServer: die Verbindung wird nach dem Handler nicht geschlossen, solange wir
+// eine Kopie des WiFiClient halten. Wenige Slots, tote Clients werden beim Senden aussortiert.
+static constexpr size_t SSE_MAX_CLIENTS = 4;
+static constexpr uint32_t SSE_PING_MS = 15000;
+static WiFiClient sseClients[SSE_MAX_CLIENTS];
+static uint32_t sseLastPingMs = 0;
+
+static void sseWrite(const char* buf, size_t len) {
+  for (auto& c : sseClients) {
+    if (!c.connected()) continue;
+    if (c.write((const uint8_t*)buf, len) != len) c.stop();
   }
 }
 
-static void setLedsForDistance(uint8_t km) {
-  // km: 0 = very close/overhead, 1..63; 63 == out of range
-  bool l1=false, l2=false, l3=false, l4=false;
-  switch (km) {
-    case 63: 
-      break;
-    case 40:
-      l1=true;
-      break;
-    case 37:
-      l2=true;
-      break;
-    case 34:
-      l1=l2=true;
-      break;
-    case 31:
-      l3=true;
-      break;
-    case 27:
-      l1=l3=true;
-      break;
-    case 24:
-      l2=l3=true;
-      break;
-    case 20:
-      l1=l2=l3=true;
-      break;
-    case 17:
-      l4=true;
-      break;
-    case 14:
-      l1=l4=true;
-      break;
-    case 12:
-      l2=l4=true;
-      break;
-    case 10:
-      l1=l2=l4=true;
-      break;
-    case  8:
-      l3=l4=true;
-      break;
-    case  6:
-      l1=l3=l4=true;
-      break;
-    case  5:
-      l2=l3=l4=true;
-      break;
-    case  1:
-      l1=l2=l3=l4=true;
-      break;
+static void handleStream(HttpRequest* req) {
+  for (auto& c : sseClients) {
+    if (c.connected()) continue;
+    c = req->client();
+    c.setTimeout(1); // langsame Clients dürfen loop() nicht lange aufhalten
+    c.print("HTTP/1.1 200 OK\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: keep-alive\r\n\r\n"
+            "retry: 3000\n\n");
+    return;
+  }
+  req->send(503, "text/plain", "zu viele Stream-Clients");
+}
+
+// Kommentarzeile als Keepalive, damit abgerissene Verbindungen erkannt werden
+static void sseMaintain() {
+  if (millis() - sseLastPingMs < SSE_PING_MS) return;
+  sseLastPingMs = millis();
+  sseWrite(": ping\n\n", 8);
+}
+#endif
+
+static size_t streamClientCount() {
+#ifdef USE_ASYNC_WEBSERVER
+  return sse.count();
+#else
+  size_t n = 0;
+  for (auto& c : sseClients) if (c.connected()) n++;
+  return n;
+#endif
+}
+
+// id = Sequenznummer des Ereignisses (0 = ohne id-Zeile)
+static void ssePush(const char* event, const char* data, uint32_t id = 0) {
+#ifdef USE_ASYNC_WEBSERVER
+  if (sse.count() > 0) sse.send(data, event, id);
+#else
+  char buf[224];
+  char idLine[20] = "";
+  if (id) snprintf(idLine, sizeof(idLine), "id: %lu\n", (unsigned long)id);
+  int n = snprintf(buf, sizeof(buf), "%sevent: %s\ndata: %s\n\n", idLine, event, data);
+  if (n > 0 && (size_t)n < sizeof(buf)) sseWrite(buf, n);
+#endif
+}
+
+static void pushStrike(const LightningEvent& e, uint32_t seq) {
+  char json[160];
+  size_t n;
+  {
+    ScopeTimer t(mJsonStrike);
+    n = formatEventJson(json, sizeof(json), e, seq);
+  }
+  if (n) ssePush("strike", json, seq);
+}
+
+static void pushLeds(uint8_t mask) {
+  char json[64];
+  auto b = [mask](unsigned i) { return (mask >> i) & 1 ? "true" : "false"; };
+  snprintf(json, sizeof(json), "{\"l1\":%s,\"l2\":%s,\"l3\":%s,\"l4\":%s}", b(0), b(1), b(2), b(3));
+  ssePush("led", json);
+}
+
+#ifdef STRIKE_BROADCAST
+// Gesammelte Blitze als ein Datagramm senden. Verloren gegangene Datagramme holt der Collector
+// über /api/events?after=<seq> nach (seq-Lücke), es wird nichts wiederholt.
+static void flushStrikeBatch() {
+  if (strikeBatch.empty()) return;
+  uint8_t buf[STRIKE_PKT_MAX];
+  const size_t n = strikeBatch.encode(buf, nodeId);
+  strikeBatch.clear();
+  if (WiFi.status() == WL_CONNECTED && strikeUdp.writeTo(buf, n, IPAddress(STRIKE_GROUP), STRIKE_PORT) == n) {
+    strikePacketsSent++;
+  } else {
+    strikeSendErrors++;
+  }
+}
+
+static void broadcastStrike(const LightningEvent& e, uint32_t seq) {
+  if (strikeBatch.add(e, seq, millis())) return;
+  flushStrikeBatch();
+  strikeBatch.add(e, seq, millis());
+}
+
+// Läuft im AsyncUDP-Task; eigene Datagramme (Multicast-Loopback) werden übersprungen
+static void onStrikePacket(AsyncUDPPacket& packet) {
+  StrikePacket pkt;
+  if (!decodeStrikePacket(packet.data(), packet.length(), pkt)) {
+    strikePacketsInvalid = strikePacketsInvalid + 1;
+    return;
+  }
+  if (pkt.nodeId == nodeId) return;
+  strikePacketsReceived = strikePacketsReceived + 1;
+  for (size_t i = 0; i < pkt.count; ++i) {
+    const LightningEvent e = strikePacketEvent(pkt, i);
+    portENTER_CRITICAL(&peerMux);
+    peers.add(pkt.nodeId, pkt.firstSeq + i, e);
+    portEXIT_CRITICAL(&peerMux);
+  }
+}
+
+static void startStrikeBroadcast() {
+  if (strikeUdp.listenMulticast(IPAddress(STRIKE_GROUP), STRIKE_PORT)) {
+    strikeUdp.onPacket(onStrikePacket);
+  }
+#ifdef SERIALDEBUG
+  else Serial.println("Multicast für Blitz-Push nicht verfügbar");
+#endif
+}
+
+// Nächstes Gewitter laut Nachbarn (km), -1 = keins; erst mit Unix-Zeit vergleichbar
+static int nearestPeerKm(time_t now) {
+  if (!clockValid) return -1;
+  portENTER_CRITICAL(&peerMux);
+  const int km = peers.nearestKm(now, PEER_MAX_AGE_SEC);
+  portEXIT_CRITICAL(&peerMux);
+  return km;
+}
+#endif
+
+// Gerätespezifischer Teil der Pipeline (event_pipeline.h); History/Statistik/Samples unter
+// HistoryLock, Live-Werte unter liveMux
+struct PipelineHooks {
+  using Lock = HistoryLock;
+  struct LiveLock {
+    LiveLock() { portENTER_CRITICAL(&liveMux); }
+    ~LiveLock() { portEXIT_CRITICAL(&liveMux); }
+  };
+
+  // Neues Ereignis ins Log und an Stream-Clients melden
+  void recorded(const LightningEvent& e, uint32_t seq) {
+    seqResume.headSeq = seq;
+    eventLog.append(e, seq);
+    pushStrike(e, seq);
+#ifdef STRIKE_BROADCAST
+    broadcastStrike(e, seq);
+#endif
   }
 
-  digitalWrite(LED1, l1 ? HIGH : LOW);
-  digitalWrite(LED2, l2 ? HIGH : LOW);
-  digitalWrite(LED3, l3 ? HIGH : LOW);
-  digitalWrite(LED4, l4 ? HIGH : LOW);
+  void restamp(LightningEvent& e) { setEventTime(e, clockAtUs(e.monoUs)); }
+};
+static PipelineHooks pipelineHooks;
+static EventPipeline<HISTORY_MAX, SAMPLES_MAX, PipelineHooks> pipeline(history, stats, samples, pipelineHooks);
+
+// Alle vier LEDs mit einem einzigen Store ins GPIO-Ausgangsregister: kein Zwischenzustand,
+// konstante Laufzeit. Die kritische Sektion hält andere Schreiber (digitalWrite der Board-LED)
+// zwischen Lesen und Schreiben fern; aufrufbar aus loop() und dem Sensor-Task.
+static portMUX_TYPE ledMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint8_t ledMask = 0; // logischer Zustand (Bit0 = LED1 … Bit3 = LED4)
+
+static inline void writeLedOutputs(uint8_t mask) {
+  portENTER_CRITICAL(&ledMux);
+  REG_WRITE(GPIO_OUT_REG, (REG_READ(GPIO_OUT_REG) & ~LED_GPIO.all) | LED_GPIO[mask]);
+  portEXIT_CRITICAL(&ledMux);
+}
+
+static inline void showLeds(uint8_t mask) {
+  ledMask = mask;
+  writeLedOutputs(mask);
+}
+
+// LEDs folgen dem Trend: aus, solange keine Warnstufe aktiv ist, sonst das Muster der
+// geschätzten aktuellen Distanz (nicht gelistete Codes → nächste Stufe, siehe led_map.h).
+// peerKm (≥ 0): näheres Gewitter eines Nachbarknotens, gewinnt gegen die eigene Schätzung.
+static uint8_t ledsForTrend(const TrendSnapshot& t, int peerKm = -1) {
+  float km = t.level == ALERT_NONE ? -1 : t.distanceKm;
+  if (peerKm >= 0 && (km < 0 || peerKm < km)) km = (float)peerKm;
+  if (km < 0) return 0;
+  return LED_LUT[(uint8_t)std::min(62.0f, km + 0.5f)];
+}
+
+// LED-Wechsel an Stream-Clients melden (geschaltet werden die LEDs im Sensor-Task)
+static void pushLedsIfChanged() {
+  static uint8_t lastLeds = 0xFF;
+  const uint8_t leds = ledMask;
+  if (leds != lastLeds) {
+    lastLeds = leds;
+    pushLeds(leds);
+  }
+}
+
+#ifdef LED_BLINK_BY_RATE
+// Blinkt das aktuelle Muster, sobald die Blitzrate LED_BLINK_MIN_RATE erreicht:
+// halbe Periode 500 ms bei der Mindestrate, 100 ms ab 60 Blitzen/min
+static void updateLedBlink(uint32_t strikesPerMin) {
+  static uint32_t lastToggleMs = 0;
+  static bool on = true;
+  if (strikesPerMin < LED_BLINK_MIN_RATE || ledMask == 0) {
+    if (!on) { on = true; writeLedOutputs(ledMask); }
+    return;
+  }
+  const uint32_t halfMs = std::max<uint32_t>(100, std::min<uint32_t>(500, 6000 / strikesPerMin));
+  if (millis() - lastToggleMs < halfMs) return;
+  lastToggleMs = millis();
+  on = !on;
+  writeLedOutputs(on ? ledMask : 0);
+}
+#endif
+
+// Läuft im SNTP-Kontext. Jede Synchronisation setzt den Offset neu; bereits genommene
+// Zeitstempel bleiben, neue laufen dank EventClock::stamp nie rückwärts.
+static void onTimeSync(struct timeval* tv) {
+  const int64_t unixUs = (int64_t)tv->tv_sec * US_PER_SEC + tv->tv_usec;
+  portENTER_CRITICAL(&clockMux);
+  eventClock.sync(unixUs, esp_timer_get_time());
+  portEXIT_CRITICAL(&clockMux);
+  clockValid = true;
+}
+
+// Nicht blockierend: SNTP meldet sich über onTimeSync, sobald die Zeit da ist
+static void setupTime() {
+  sntp_set_time_sync_notification_cb(onTimeSync);
+  configTzTime("CET-1CEST,M3.5.0,M10.5.0/3", "pool.ntp.org", "time.nist.gov"); // EU Regel
+}
+
+// Schneller Verbindungsaufbau: BSSID und Kanal des letzten APs überleben Resets (nicht das
+// Ausschalten) im RTC-RAM. Damit entfällt der Kanal-Scan; passt der Eintrag nicht mehr, wird
+// er verworfen und normal gesucht.
+struct WifiFastConnect {
+  uint32_t magic;
+  uint8_t bssid[6];
+  int32_t channel;
+};
+static constexpr uint32_t WIFI_FAST_MAGIC = 0x57464331; // "WFC1"
+RTC_NOINIT_ATTR static WifiFastConnect wifiFast;
+static bool wifiFastTried = false; // laufender Versuch nutzt wifiFast
+
+static void beginWiFi() {
+  wifiFastTried = wifiFast.magic == WIFI_FAST_MAGIC && wifiFast.channel > 0 && wifiFast.channel <= 14;
+  if (wifiFastTried) WiFi.begin(WIFI_SSID, WIFI_PASSWORD, wifiFast.channel, wifiFast.bssid);
+  else WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
 }
 
-static unsigned long nextRetryMs = 0;
 void onWiFiEvent(WiFiEvent_t event) {
   switch (event) {
     case ARDUINO_EVENT_WIFI_STA_START:
 #ifdef SERIALDEBUG    
-      Serial.println("[WiFi] STA_START → begin connect");
+      Serial.println("[WiFi] STA_START");
 #endif
-      WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
       break;
     case ARDUINO_EVENT_WIFI_STA_CONNECTED:
 #ifdef SERIALDEBUG    
@@ -202,408 +859,1381 @@ void onWiFiEvent(WiFiEvent_t event) {
 #ifdef SERIALDEBUG    
       Serial.printf("[WiFi] IP: %s\n", WiFi.localIP().toString().c_str());
 #endif
-      nextRetryMs = 0; // reset backoff
+      portENTER_CRITICAL(&wifiMux);
+      wifiBackoff.reset();
+      portEXIT_CRITICAL(&wifiMux);
+      if (wifiDisconnects) wifiReconnects++;
+      memcpy(wifiFast.bssid, WiFi.BSSID(), sizeof(wifiFast.bssid));
+      wifiFast.channel = WiFi.channel();
+      wifiFast.magic = WIFI_FAST_MAGIC;
+      wifiFastTried = false;
+      {
+        static bool ntpStarted = false; // SNTP bleibt über Reconnects hinweg aktiv
+        if (!ntpStarted) {
+          ntpStarted = true;
+          setupTime();
+#ifdef STRIKE_BROADCAST
+          startStrikeBroadcast();
+#endif
+        }
+      }
       break;
     case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
 #ifdef SERIALDEBUG    
       Serial.printf("[WiFi] Disconnected → retry soon\n");
 #endif
-      // kleiner Backoff (10 s)
-      nextRetryMs = millis() + 10000;
+      wifiDisconnects++;
+      if (wifiFastTried) {
+        // AP gewechselt/Kanal geändert: Cache verwerfen, sofort neu mit Scan verbinden
+        wifiFast.magic = 0;
+        beginWiFi();
+        break;
+      }
+      // sonst wiederholt der Supervisor mit Backoff (auch wenn ein Versuch ohne Event hängt)
+      portENTER_CRITICAL(&wifiMux);
+      wifiBackoff.arm(millis());
+      portEXIT_CRITICAL(&wifiMux);
       break;
     default: break;
   }
 }
 
-static bool connectWiFi() {
+// Startet nur den Verbindungsaufbau; IP, NTP usw. kommen über onWiFiEvent
+static void connectWiFi() {
+  WiFi.onEvent(onWiFiEvent);
   WiFi.mode(WIFI_STA);
   WiFi.persistent(false);                 // keine NVS-Schreiberei beim Reconnect
-  WiFi.setAutoReconnect(true);            // automatische Reconnects erlauben
+  WiFi.setAutoReconnect(false);           // Reconnects macht der Supervisor (mit Backoff)
+#ifdef LOW_POWER
+  esp_wifi_set_ps(WIFI_PS_MIN_MODEM);     // Modem-Sleep: Empfänger nur zu den DTIM-Beacons an
+#else
   esp_wifi_set_ps(WIFI_PS_NONE);          // Stromsparen aus → stabilere Verbindungen
-  WiFi.onEvent(onWiFiEvent);
+#endif
 
-  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  beginWiFi();
 #ifdef SERIALDEBUG    
-  Serial.print("WLAN verbinden...");
+  Serial.printf("WLAN verbinden (%s)...\n", wifiFastTried ? "BSSID/Kanal aus dem Cache" : "Scan");
 #endif
-  unsigned long start = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - start < 20000) {
-    delay(250);
-  }
-#ifdef SERIALDEBUG    
-  Serial.println();
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.print("Verbunden: ");
-    Serial.println(WiFi.localIP());
-  } else {
-    Serial.println("WLAN-Verbindung fehlgeschlagen (Starte AP-Modus wäre Option)");
-  }
-#endif
-  return (WiFi.status() == WL_CONNECTED);
-
-}
-
-static void setupTime() {
-  configTzTime("CET-1CEST,M3.5.0,M10.5.0/3", "pool.ntp.org", "time.nist.gov"); // EU Regel
-  // etwas warten, bis Zeit gesetzt ist
-  for (int i=0;i<10;i++) {
-    time_t now = time(nullptr);
-    if (now > 1600000000) break; // plausibel
-    delay(500);
-  }
 }
 
 // =============================
 // Webserver-Handler
 // =============================
-static void handleRoot() {
-  String html = R"HTML(
-<!doctype html>
-<html lang="de"><head><meta charset="utf-8"/>
-<meta name="viewport" content="width=device-width, initial-scale=1"/>
-<title>AS3935 Lightning Monitor</title>
-<style>body{font-family:system-ui,Segoe UI,Roboto,Arial;margin:2rem;max-width:800px} .card{border:1px solid #ddd;border-radius:12px;padding:1rem;margin:1rem 0;box-shadow:0 2px 8px rgba(0,0,0,.05)} code{background:#f5f5f5;padding:.1rem .3rem;border-radius:4px}</style>
-</head>
-<body>
-<h1>AS3935 Lightning Monitor</h1>
-
-<div class="card">
-  <h2>LED-Status</h2>
-  <div id="led-panel">
-    <svg viewBox="0 0 320 90" class="led-svg" aria-label="LED Status">
-      <!-- Filter für Glow -->
-      <defs>
-        <filter id="glow" x="-50%" y="-50%" width="200%" height="200%">
-          <feGaussianBlur stdDeviation="3" result="coloredBlur"/>
-          <feMerge>
-            <feMergeNode in="coloredBlur"/>
-            <feMergeNode in="SourceGraphic"/>
-          </feMerge>
-        </filter>
-      </defs>
-
-      <!-- LED1 Grün -->
-      <g id="led1" class="led" data-color="green" transform="translate(40,45)">
-        <circle r="22" class="ring"/>
-        <circle r="18" class="dot"/>
-        <text y="36" text-anchor="middle" class="label">LED1</text>
-      </g>
-
-      <!-- LED2 Grün -->
-      <g id="led2" class="led" data-color="green" transform="translate(120,45)">
-        <circle r="22" class="ring"/>
-        <circle r="18" class="dot"/>
-        <text y="36" text-anchor="middle" class="label">LED2</text>
-      </g>
-
-      <!-- LED3 Gelb -->
-      <g id="led3" class="led" data-color="yellow" transform="translate(200,45)">
-        <circle r="22" class="ring"/>
-        <circle r="18" class="dot"/>
-        <text y="36" text-anchor="middle" class="label">LED3</text>
-      </g>
-
-      <!-- LED4 Rot -->
-      <g id="led4" class="led" data-color="red" transform="translate(280,45)">
-        <circle r="22" class="ring"/>
-        <circle r="18" class="dot"/>
-        <text y="36" text-anchor="middle" class="label">LED4</text>
-      </g>
-    </svg>
-  </div>
-</div>
-
-<style>
-  .led-svg { width:100%; height:auto; max-height:140px; }
-  .led .ring { fill:#f3f3f3; stroke:#d0d0d0; stroke-width:2; }
-  .led .dot  { fill:#bfbfbf; }
-
-  .led.on[data-color="green"]  .dot { fill:#20c064; filter:url(#glow); }
-  .led.on[data-color="yellow"] .dot { fill:#f5c542; filter:url(#glow); }
-  .led.on[data-color="red"]    .dot { fill:#ff5555; filter:url(#glow); }
-  .led .label { font: 12px/1.2 system-ui, Segoe UI, Roboto, Arial; fill:#555; }
-
-</style>
-
-
-
-<div class="card" id="live">Lädt Live-Daten…</div>
-
-
-<style>
-  body{font-family:system-ui,Segoe UI,Roboto,Arial;margin:20px;max-width:980px}
-  .row{display:grid;gap:16px}
-  .card{border:1px solid #ddd;border-radius:12px;padding:16px;box-shadow:0 2px 8px rgba(0,0,0,.06)}
-  h2{margin:.2rem 0 1rem}
-  canvas{width:100%;height:260px;border-radius:8px;background:#fff}
-  .meta{font-size:.9rem;color:#555}
-</style>
-</head>
-<body>
-  
-  <div class="row">
-    <div class="card">
-      <h2>Distanz (km) – letzte 60 Minuten</h2>
-      <canvas id="dist"></canvas>
-    </div>
-    <div class="card">
-      <h2>log10(Energie) – letzte 60 Minuten</h2>
-      <canvas id="energy"></canvas>
-    </div>
-  </div>
-
-  <div class="card" id="list">Lädt Events…</div>
-
-  <div class="card">
-    <h2>API</h2>
-    <ul>
-      <li><code>/api/events?since=3600</code> – Ereignisse letzte Stunde</li>
-      <li><code>/api/live</code> – Status</li>
-      <li><code>/api/stats?range=hour|day</code> – Statistik</li>
-    </ul>
-  </div>
-
-<script>
-const MINUTES = 60;
-const PAD = {l:48, r:12, t:12, b:28};
-
-function pxMap(x, x0, x1, w) {
-  return PAD.l + (x - x0) * (w - PAD.l - PAD.r) / (x1 - x0);
-}
-function pyMap(y, y0, y1, h) {
-  return (h - PAD.b) - (y - y0) * (h - PAD.t - PAD.b) / (y1 - y0);
-}
-function drawAxes(ctx, w, h, x0, x1, y0, y1, xLabel, yLabel) {
-  ctx.clearRect(0,0,w,h);
-  ctx.lineWidth = 1; ctx.strokeStyle = "#888"; ctx.fillStyle="#000";
-  // Axen
-  ctx.beginPath();
-  ctx.moveTo(PAD.l, PAD.t); ctx.lineTo(PAD.l, h-PAD.b); ctx.lineTo(w-PAD.r, h-PAD.b);
-  ctx.stroke();
-  ctx.font = "12px system-ui,Segoe UI,Arial";
-
-  // X-Ticks (alle 10 Minuten)
-  for (let m = x0; m <= x1; m+=10) {
-    const x = pxMap(m, x0, x1, w);
-    ctx.strokeStyle="#ccc";
-    ctx.beginPath(); ctx.moveTo(x, h-PAD.b); ctx.lineTo(x, PAD.t); ctx.stroke();
-    ctx.fillStyle="#333";
-    ctx.fillText(String(m), x-8, h-8);
-  }
-  // Y-Ticks (5 Schritte)
-  for (let i=0;i<=5;i++){
-    const yv = y0 + (i*(y1-y0)/5);
-    const y = pyMap(yv, y0, y1, h);
-    ctx.strokeStyle="#eee";
-    ctx.beginPath(); ctx.moveTo(PAD.l, y); ctx.lineTo(w-PAD.r, y); ctx.stroke();
-    ctx.fillStyle="#333";
-    ctx.fillText(yv.toFixed( (y1-y0)>20 ? 0 : 1 ), 8, y+4);
-  }
-  // Labels
-  ctx.fillStyle="#555";
-  ctx.fillText(xLabel, w/2-40, h-4);
-  ctx.save(); ctx.translate(14, h/2); ctx.rotate(-Math.PI/2); ctx.fillText(yLabel, -40, 0); ctx.restore();
-}
-
-function scatter(ctx, w, h, points, x0, x1, y0, y1) {
-  ctx.fillStyle = "#0a84ff"; // Distanz / Energie Punkte
-  for (const p of points) {
-    const x = pxMap(p.x, x0, x1, w);
-    const y = pyMap(p.y, y0, y1, h);
-    ctx.beginPath(); ctx.arc(x, y, 3, 0, Math.PI*2); ctx.fill();
-  }
-}
-
-function setLedState(id, on) {
-  const el = document.getElementById(id);
-  if (!el) return;
-  el.classList.toggle('on', !!on);
-}
-
-async function last_events() {
-  const live = await fetch('/api/live').then(r=>r.json());
-  document.getElementById('live').innerHTML = 
-    `<b>Sensor gestartet    :</b> ${live.started}` +
-    `<br><b>Letzte Distanz  :</b> ${live.last_distance_km} km` +
-    `<br><b>Letzte Energie  :</b> ${live.last_energy}` +
-    `<br><b>Letztes Ereignis:</b> ${live.last_event_string} um ${live.last_event_iso || '—'} durch ${live.last_event_trigger}` +
-    `<br><b>Uptime (s)      :</b> ${live.uptime_s}`;
-  const evts = await fetch('/api/events?since=3600').then(r=>r.json());
-  document.getElementById('list').innerHTML = `<b>${evts.events.length}</b> Ereignisse (letzte Stunde)`+
-    `<pre>${JSON.stringify(evts, null, 2)}</pre>`;
-
-  // LED-Status setzen (du hast doc["l1"]..doc["l4"])
-  setLedState('led1', live.l1);
-  setLedState('led2', live.l2);
-  setLedState('led3', live.l3);
-  setLedState('led4', live.l4);
-}
-
-async function load() {
-  const nowSec = Math.floor(Date.now()/1000);
-
-  // Events der letzten Stunde
-  const ev = await fetch('/api/events?since=3600').then(r=>r.json()).catch(_=>({events:[]}));
-  const events = (ev.events||[]).map(e=>{
-    const minsAgo = Math.max(0, Math.round((nowSec - (e.ts||nowSec))/60));
-    const dist = (typeof e.distance_km === 'number') ? -e.distance_km : -63;
-    const energy = Math.max(0, Number(e.energy||0));
-    const elog = Math.log10(energy+1); // gegen 0 stabil
-    return {minsAgo, dist, elog};
-  }).filter(e=>e.minsAgo<=MINUTES);
-
-  // Sortiere nach Minuten (aufsteigend 0..60 für schöne Linien)
-  events.sort((a,b)=>a.minsAgo-b.minsAgo);
-
-  // --- Distanz-Chart ---
-  const c1 = document.getElementById('dist');
-  c1.width = c1.clientWidth * window.devicePixelRatio;
-  c1.height = c1.clientHeight * window.devicePixelRatio;
-  const g1 = c1.getContext('2d'); g1.scale(window.devicePixelRatio, window.devicePixelRatio);
-
-  const x0 = 0, x1 = MINUTES;
-  const y0d = -63, y1d = 0; // 63 = out of range
-  drawAxes(g1, c1.clientWidth, c1.clientHeight, x0, x1, y0d, y1d, "Minuten ago", "km");
-  scatter(g1, c1.clientWidth, c1.clientHeight, events.map(e=>({x:e.minsAgo,y:e.dist})), x0, x1, y0d, y1d);
-
-  // --- Energie-Chart ---
-  const c2 = document.getElementById('energy');
-  c2.width = c2.clientWidth * window.devicePixelRatio;
-  c2.height = c2.clientHeight * window.devicePixelRatio;
-  const g2 = c2.getContext('2d'); g2.scale(window.devicePixelRatio, window.devicePixelRatio);
-
-  // Y-Range für log10(energy): automatisch aus Daten (Fallback 0..6)
-  let ymin = 0, ymax = 6;
-  if (events.length) {
-    ymin = 0; // wir starten bei 0
-    ymax = Math.max(1, Math.ceil(Math.max(...events.map(e=>e.elog))*1.1));
-    ymax = Math.min(8, ymax); // Deckel drauf
-  }
-  drawAxes(g2, c2.clientWidth, c2.clientHeight, x0, x1, ymin, ymax, "Minuten ago", "log10(E)");
-  scatter(g2, c2.clientWidth, c2.clientHeight, events.map(e=>({x:e.minsAgo,y:e.elog})), x0, x1, ymin, ymax);
-}
-
-load();
-last_events();
-
-setInterval(last_events, 10000);
-setTimeout(() => setInterval(load, 10000), 2000); // 2 s versetzt
-
-</script>
+// Antwort-Hilfen: kapseln die Unterschiede zwischen WebServer und AsyncWebServer.
+// hasArg/arg/header/send(code, type, body) haben in beiden Bibliotheken dieselbe Form.
 
+// Für Streams, die selbst sperren (MetricsStream)
+struct NoStreamLock {
+  NoStreamLock() {}
+};
 
-</body></html>
-)HTML";
-  server.send(200, "text/html", html);
+// Chunked-Antwort aus einem Stream-Objekt mit read(char*, size_t); L sperrt Konstruktor und
+// jedes read() (Vorgabe: HistoryLock für die History-Streams)
+template <typename S, typename L = HistoryLock, typename... Args>
+static void sendStream(HttpRequest* req, const char* type, Args&&... args) {
+#ifdef USE_ASYNC_WEBSERVER
+  // Der Stream lebt, bis AsyncWebServer den letzten Chunk abgeholt hat
+  std::shared_ptr<S> stream;
+  {
+    L lock; // Konstruktor liest Start-/Endposition der History
+    stream = std::make_shared<S>(std::forward<Args>(args)...);
+  }
+  req->send(req->beginChunkedResponse(type, [stream](uint8_t* buf, size_t maxLen, size_t) -> size_t {
+    L lock;
+    return stream->read((char*)buf, maxLen);
+  }));
+#else
+  S stream(std::forward<Args>(args)...);
+  sendStreamChunked<L>(*req, type, stream); // event_pipeline.h, im Host-Test geprüft
+#endif
 }
 
-static void handleLive() {
+// Handler registrieren – Signatur ist in beiden Modi void(HttpRequest*). Die Laufzeit jedes
+// Handlers landet in http_handler_us{path=…} (async: nur bis zur Übergabe der Antwort).
+static void route(const char* uri, void (*fn)(HttpRequest*)) {
+  RouteStat* st = routeCount < MAX_ROUTES ? &routeStats[routeCount++] : nullptr;
+  if (st) st->uri = uri;
+#ifdef USE_ASYNC_WEBSERVER
+  server.on(uri, HTTP_ANY, [fn, st](AsyncWebServerRequest* req) {
+#ifdef LOW_POWER
+    lastRequestMs = millis();
+#endif
+    if (!st) { fn(req); return; }
+    ScopeTimer t(st->h);
+    fn(req);
+  });
+#else
+  server.on(uri, HTTP_ANY, [fn, st]() {
+#ifdef LOW_POWER
+    lastRequestMs = millis();
+#endif
+    if (!st) { fn(&server); return; }
+    ScopeTimer t(st->h);
+    fn(&server);
+  });
+#endif
+}
+
+static void handleRoot(HttpRequest* req) {
+  // Dashboard liegt gzip-komprimiert im Flash (aus data/index.html, siehe scripts/embed_dashboard.py).
+  // Keine Heap-Kopie pro Anfrage; wiederholte Aufrufe mit passendem ETag bekommen nur 304.
+  const bool notModified = req->header("If-None-Match") == DASHBOARD_ETAG;
+#ifdef USE_ASYNC_WEBSERVER
+  AsyncWebServerResponse* res = notModified
+    ? req->beginResponse(304)
+    : req->beginResponse(200, "text/html", DASHBOARD_GZ, DASHBOARD_GZ_LEN);
+  res->addHeader("ETag", DASHBOARD_ETAG);
+  res->addHeader("Cache-Control", "no-cache");
+  if (!notModified) res->addHeader("Content-Encoding", "gzip");
+  req->send(res);
+#else
+  req->sendHeader("ETag", DASHBOARD_ETAG);
+  req->sendHeader("Cache-Control", "no-cache");
+  if (notModified) {
+    req->send(304);
+    return;
+  }
+  req->sendHeader("Content-Encoding", "gzip");
+  req->send_P(200, "text/html", (PGM_P)DASHBOARD_GZ, DASHBOARD_GZ_LEN);
+#endif
+}
+
+static void handleLive(HttpRequest* req) {
+  const LiveState live = pipeline.live(); // alle Werte vom selben Blitz
   DynamicJsonDocument doc(1024);
   doc["ip"] = WiFi.localIP().toString();
-  doc["last_distance_km"] = lastDistance;
-  doc["last_energy"] = lastEnergy;;
-  doc["last_event_ts"] = (int64_t)lastEventTs;
-  doc["last_event"] = lastEvent;
+  doc["last_distance_km"] = live.distance;
+  doc["last_energy"] = live.energy;
+  doc["last_event_ts"] = (int64_t)live.eventTs;
+  doc["last_event"] = live.event;
   // 0 = keine, 1 = Noise, 4 = Disturber, 8 = Lightning (abhängig von Lib – Doku prüfen)
   String lastEventString;
-  if (lastEvent == 0) {
+  if (live.event == 0) {
     lastEventString = "Kein";
   } else {
     bool first = true;
     auto add = [&](const char* s){ if(!first) lastEventString += ", "; lastEventString += s; first = false; };
 
-    if (lastEvent & 0x08) add("Blitz");      // lightning
-    if (lastEvent & 0x04) add("Störer");     // disturber
-    if (lastEvent & 0x01) add("Rauschen");   // noise
+    if (live.event & 0x08) add("Blitz");      // lightning
+    if (live.event & 0x04) add("Störer");     // disturber
+    if (live.event & 0x01) add("Rauschen");   // noise
 
     if (first) { // kein bekanntes Bit gesetzt
       lastEventString = "Unbekannt";
     }
   }
-  lastEventString=lastEventString + (" :: Wert binär =") + String(lastEvent,BIN);
+  lastEventString=lastEventString + (" :: Wert binär =") + String(live.event,BIN);
   doc["last_event_string"] = lastEventString;
-  doc["last_event_iso"] = lastEventTs ? tsToIso8601(lastEventTs) : String("");
-  doc["last_event_trigger"] = AS3935_irq ? String("Interrupt") : String("Polling");
+  doc["last_event_iso"] = live.eventTs ? tsToIso8601(live.eventTs) : String("");
+  doc["last_event_trigger"] = live.irq ? String("Interrupt") : String("Polling");
   doc["uptime_s"] = (uint32_t)(millis()/1000);
   doc["started"] = AS3935_started ? String("Ja, I2C Up") : String("Nein, I2C Down");
 
-  // LED-Status in JSON exportieren (HIGH = an)
-  // Falls deine Logik invertiert ist, entsprechend anpassen.
-  doc["l1"] = (digitalRead(LED1) == HIGH);
-  doc["l2"] = (digitalRead(LED2) == HIGH);
-  doc["l3"] = (digitalRead(LED3) == HIGH);
-  doc["l4"] = (digitalRead(LED4) == HIGH);
+  // LED-Status in JSON exportieren (logisches Muster, unabhängig von der Blinkphase)
+  const uint8_t leds = ledMask;
+  doc["l1"] = (leds & 0x1) != 0;
+  doc["l2"] = (leds & 0x2) != 0;
+  doc["l3"] = (leds & 0x4) != 0;
+  doc["l4"] = (leds & 0x8) != 0;
 
   String out;
-  serializeJson(doc, out);
-  server.send(200, "application/json", out);
+  {
+    ScopeTimer t(mJsonLive);
+    serializeJson(doc, out);
+  }
+  req->send(200, "application/json", out);
 }
 
-static void handleEvents() {
-  // Parameter since=Sekunden (default 3600)
-  long sinceSec = 3600;
-  if (server.hasArg("since")) {
-    sinceSec = server.arg("since").toInt();
+// Gemeinsame Parameter von /api/events und /api/events.bin
+//   since=Sekunden (default 3600, im Delta-Modus default: alles)
+//   from=/to=      absoluter Zeitbereich (Unix-Sekunden, beide inklusive); from ersetzt since
+//   after=<seq>    nur neuere Einträge, älteste zuerst (Delta-Abfrage)
+//   limit=<n>      max. Anzahl Einträge (Blättern über after=<letzte seq>)
+//   order=asc|desc Reihenfolge (default: desc, im Delta-Modus asc)
+//   min_km=/max_km=/min_energy=/event=<Maske>  Wertefilter (nur /api/events; event wie
+//                  REG0x03: 8 = Blitz, 4 = Störer, 1 = Rauschen)
+static EventQuery parseEventQuery(HttpRequest* req) {
+  EventQuery q;
+  q.hasAfter = req->hasArg("after");
+  if (q.hasAfter) q.afterSeq = strtoul(req->arg("after").c_str(), nullptr, 10);
+  if (req->hasArg("limit")) q.limit = strtoul(req->arg("limit").c_str(), nullptr, 10);
+
+  long sinceSec = q.hasAfter ? 0 : 3600;
+  if (req->hasArg("since")) {
+    sinceSec = req->arg("since").toInt();
     if (sinceSec <= 0) sinceSec = 3600;
   }
-  time_t now = time(nullptr);
-  time_t cutoff = now - sinceSec;
+  if (req->hasArg("from")) q.cutoff = (time_t)strtoll(req->arg("from").c_str(), nullptr, 10);
+  else if (sinceSec > 0) q.cutoff = time(nullptr) - sinceSec;
+  if (req->hasArg("to")) q.until = (time_t)strtoll(req->arg("to").c_str(), nullptr, 10);
+
+  if (req->hasArg("min_km")) q.minKm = (uint8_t)std::min(63L, std::max(0L, req->arg("min_km").toInt()));
+  if (req->hasArg("max_km")) q.maxKm = (uint8_t)std::min(63L, std::max(0L, req->arg("max_km").toInt()));
+  if (req->hasArg("min_energy")) q.minEnergy = strtoul(req->arg("min_energy").c_str(), nullptr, 10);
+  if (req->hasArg("event")) q.eventMask = (uint8_t)(strtoul(req->arg("event").c_str(), nullptr, 0) & PACK_EVENT_MASK);
+  const String order = req->arg("order");
+  if (order == "asc") q.order = 1;
+  else if (order == "desc") q.order = -1;
+  return q;
+}
+
+static void handleEvents(HttpRequest* req) {
+  // Chunked Transfer: Zeilen direkt aus der History in einen festen Puffer
+  sendStream<EventJsonStream<decltype(history)>>(req, "application/json", history, parseEventQuery(req));
+}
+
+// Gepackte Einträge mit versioniertem Header, Format siehe event_binary.h / readme.md
+static void handleEventsBin(HttpRequest* req) {
+  sendStream<EventBinaryStream<decltype(history)>>(req, "application/octet-stream", history, parseEventQuery(req));
+}
+
+// range=5min|15min|hour|day oder Sekunden (max. 24h), Default hour
+static long parseRangeSec(HttpRequest* req) {
+  String range = req->arg("range");
+  long sinceSec = 3600;
+  if (range == "day") sinceSec = 24*3600;
+  else if (range == "15min") sinceSec = 15*60;
+  else if (range == "5min") sinceSec = 5*60;
+  else if (range.toInt() > 0) sinceSec = std::min<long>(range.toInt(), 24*3600);
+  return sinceSec;
+}
+
+static void handleStats(HttpRequest* req) {
+  const long sinceSec = parseRangeSec(req);
+
+  // O(1) für die Standardfenster, sonst max. 1440 Minuten-Slots – kein Scan über die History
+  StatsBuckets s;
+  {
+    HistoryLock lock;
+    s = stats.query(sinceSec);
+  }
+
+  DynamicJsonDocument doc(1024);
+  doc["range_s"] = sinceSec;
+  doc["count"] = s.count();
+  JsonObject b = doc.createNestedObject("buckets");
+  b["near_<=5km"] = s.near;
+  b["mid_6-15km"] = s.mid;
+  b[">15km"] = s.far_;
+  b["out_of_range"] = s.oor;
+
+  String out;
+  {
+    ScopeTimer t(mJsonStats);
+    serializeJson(doc, out);
+  }
+  req->send(200, "application/json", out);
+}
+
+// Trend: Blitzrate, Annäherung (Regression Distanz über Zeit), ETA bis 0 km, Warnstufe
+static void fillTrendJson(JsonDocument& doc, const TrendSnapshot& t) {
+  doc["rate_per_min"] = t.ratePerMin;
+  if (t.distanceKm >= 0) doc["distance_km"] = t.distanceKm;
+  else doc["distance_km"] = nullptr;
+  if (t.regression) doc["approach_kmh"] = t.approachKmh;
+  else doc["approach_kmh"] = nullptr;
+  if (t.etaMin >= 0) doc["eta_min"] = t.etaMin;
+  else doc["eta_min"] = nullptr;
+  doc["level"] = t.level;
+  doc["level_name"] = alertLevelName(t.level);
+  doc["strikes"] = t.strikes;
+  doc["last_strike_ts"] = (int64_t)t.lastTs;
+}
+
+static void handleTrend(HttpRequest* req) {
+  DynamicJsonDocument doc(512);
+  fillTrendJson(doc, trendSnapshot(eventNow()));
+
+  String out;
+  serializeJson(doc, out);
+  req->send(200, "application/json", out);
+}
 
-  DynamicJsonDocument doc(32768);
-  JsonArray arr = doc.createNestedArray("events");
+// Vorgebinnte Diagrammdaten aus den Minuten-Aggregaten (kein Blick in die History):
+//   range wie /api/stats, bin=Sekunden pro Bin (Vielfaches von 60, default 60)
+// Arrays mit Index 0 = Bin mit der laufenden Minute; Bin i endet bei end - i * bin_s.
+// min_km/avg_km sind null, wenn im Bin kein Blitz mit Distanz lag.
+static constexpr size_t SERIES_MAX_BINS = 120;
+
+static void handleSeries(HttpRequest* req) {
+  const long rangeSec = parseRangeSec(req);
+  uint32_t binMin = req->hasArg("bin") ? (uint32_t)std::max(1L, req->arg("bin").toInt() / 60) : 1;
+  size_t bins = (MinuteAggregates::minutesFor(rangeSec) + binMin - 1) / binMin;
+  if (bins > SERIES_MAX_BINS) { // zu fein für den Bereich → Bins vergrößern
+    binMin = (MinuteAggregates::minutesFor(rangeSec) + SERIES_MAX_BINS - 1) / SERIES_MAX_BINS;
+    bins = (MinuteAggregates::minutesFor(rangeSec) + binMin - 1) / binMin;
+  }
 
-  for (auto it = history.rbegin(); it != history.rend(); ++it) {
-    if (it->ts < cutoff) break;
+  static SeriesBin s[SERIES_MAX_BINS]; // nicht auf den Handler-Stack
+  uint32_t curMin;
+  {
+    HistoryLock lock;
+    stats.series(binMin, bins, s);
+    curMin = stats.currentMinute();
+  }
+
+  DynamicJsonDocument doc(8192);
+  doc["range_s"] = rangeSec;
+  doc["bin_s"] = binMin * 60;
+  doc["end"] = (int64_t)(curMin + 1) * 60;
+  JsonArray count = doc.createNestedArray("count");
+  JsonArray minKm = doc.createNestedArray("min_km");
+  JsonArray avgKm = doc.createNestedArray("avg_km");
+  JsonArray maxEnergy = doc.createNestedArray("max_energy");
+  for (size_t i = 0; i < bins; ++i) {
+    count.add(s[i].count);
+    if (s[i].nKm) {
+      minKm.add(s[i].minKm);
+      avgKm.add(roundf(s[i].avgKm() * 10) / 10);
+    } else {
+      minKm.add(nullptr);
+      avgKm.add(nullptr);
+    }
+    maxEnergy.add(s[i].maxEnergy);
+  }
+
+  String out;
+  serializeJson(doc, out);
+  req->send(200, "application/json", out);
+}
+
+// Distanz-Nachlesungen (kein Blitz), ältestes zuerst
+static void handleSamples(HttpRequest* req) {
+  DynamicJsonDocument doc(4096); // 32 Samples à 4 Felder
+  JsonArray arr = doc.createNestedArray("samples");
+  {
+    HistoryLock lock;
+    for (const DistanceSample& s : samples) {
+      JsonObject o = arr.createNestedObject();
+      o["ts"] = (int64_t)s.ts;
+      o["distance_km"] = s.distance;
+      o["energy"] = s.energy;
+      o["type"] = "sample";
+    }
+  }
+  String out;
+  serializeJson(doc, out);
+  req->send(200, "application/json", out);
+}
+
+#ifdef STRIKE_BROADCAST
+// Nachbarknoten mit ihrem letzten Blitz (aus dem Multicast-Push)
+static void handlePeers(HttpRequest* req) {
+  static PeerTable<PEER_MAX> snap; // nicht auf den Handler-Stack
+  portENTER_CRITICAL(&peerMux);
+  snap = peers;
+  portEXIT_CRITICAL(&peerMux);
+
+  DynamicJsonDocument doc(3072); // 16 Knoten à 6 Felder
+  char id[9];
+  snprintf(id, sizeof(id), "%08lx", (unsigned long)nodeId);
+  doc["node"] = id;
+  doc["nearest_km"] = nearestPeerKm(time(nullptr));
+  JsonArray arr = doc.createNestedArray("peers");
+  for (size_t i = 0; i < snap.size(); ++i) {
+    const PeerStrike& p = snap[i];
     JsonObject o = arr.createNestedObject();
-    o["ts"] = (int64_t)it->ts;
-    o["iso"] = tsToIso8601(it->ts);
-    o["distance_km"] = it->distance;
-    o["energy"] = it->energy;
-    o["event"] = it->event;
-    o["irq"] = it->irq;
+    snprintf(id, sizeof(id), "%08lx", (unsigned long)p.nodeId);
+    o["node"] = id;
+    o["ts"] = (int64_t)p.ts;
+    o["distance_km"] = p.distance;
+    o["strikes"] = p.strikes;
+    o["last_seq"] = p.lastSeq;
+    o["lost"] = p.lost;
+  }
+  String out;
+  serializeJson(doc, out);
+  req->send(200, "application/json", out);
+}
+#endif
+
+// Noise-/Disturber-Zähler, Minuten-Histogramm (Index 0 = laufende Minute) und AFE-Einstellungen
+static void handleInterference(HttpRequest* req) {
+  const time_t now = time(nullptr);
+  static InterferenceStats snap; // 480 Byte, nicht auf den Handler-Stack
+  AfeSettings cur;
+  uint32_t adjustments;
+  portENTER_CRITICAL(&interferenceMux);
+  snap = interference;
+  cur = afeTuner.settings();
+  adjustments = afeTuner.adjustments();
+  portEXIT_CRITICAL(&interferenceMux);
+
+  DynamicJsonDocument doc(2048);
+  doc["noise_total"] = snap.totals().noise;
+  doc["disturber_total"] = snap.totals().disturber;
+  const InterferenceCounts w5 = snap.window(now, 5);
+  const InterferenceCounts w60 = snap.window(now, 60);
+  doc["noise_5min"] = w5.noise;
+  doc["disturber_5min"] = w5.disturber;
+  doc["noise_60min"] = w60.noise;
+  doc["disturber_60min"] = w60.disturber;
+  JsonArray hn = doc.createNestedArray("noise_per_min");
+  JsonArray hd = doc.createNestedArray("disturber_per_min");
+  for (uint32_t k = 0; k < InterferenceStats::SLOTS; ++k) {
+    const InterferenceCounts c = snap.minuteAgo(now, k);
+    hn.add(c.noise);
+    hd.add(c.disturber);
   }
+  JsonObject afe = doc.createNestedObject("afe");
+  afe["noise_level"] = cur.noiseLevel;
+  afe["watchdog"] = cur.watchdog;
+  afe["spike_rejection"] = cur.spike;
+  afe["mask_disturber"] = cur.maskDisturber;
+  afe["adjustments"] = adjustments;
+#ifdef AFE_NO_AUTOTUNE
+  afe["autotune"] = false;
+#else
+  afe["autotune"] = true;
+#endif
+  // Zähler des Sensor-Tasks, einzeln gelesen (32-Bit-Zugriffe sind atomar)
+  JsonObject irq = doc.createNestedObject("irq");
+  irq["edges"] = irqGuard.edges();
+  irq["reads"] = irqGuard.reads();
+  irq["coalesced"] = irqGuard.coalesced();
+  irq["storms"] = irqGuard.storms();
+  irq["storm_active"] = irqGuard.active();
+  irq["rate_per_s"] = irqGuard.lastRate();
+  irq["max_per_s"] = IRQ_STORM_MAX_PER_SEC;
+  irq["hold_ms"] = irqGuard.holdMs();
 
   String out;
   serializeJson(doc, out);
-  server.send(200, "application/json", out);
+  req->send(200, "application/json", out);
 }
 
-static void handleStats() {
-  String range = server.arg("range");
-  long sinceSec = (range == "day") ? 24*3600 : 3600;
-  time_t now = time(nullptr);
-  time_t cutoff = now - sinceSec;
+// Prometheus-Textformat (text/plain; version=0.0.4), Latenzen in µs. Die Seite (~26 KB) entsteht
+// abschnittsweise in einem festen Puffer und geht per sendStream() in Chunks raus – kein großer
+// String am Stück. Ein Abschnitt = höchstens ein Histogramm bzw. eine Handvoll Einzelwerte.
+static constexpr size_t METRICS_CHUNK_MAX = 2048; // größter Abschnitt: Routen-Histogramm mit Kopf ≈ 1,5 KB
+using MetricsPage = MetricsBuffer<METRICS_CHUNK_MAX>;
+static_assert(sizeof(MetricsStream<METRICS_CHUNK_MAX>) + 64 <= HEAP_RESTART_BLOCK_BYTES,
+              "Supervisor-Schwelle muss den MetricsStream (async: make_shared) abdecken");
+
+static bool renderMetrics(MetricsPage& out, size_t step) {
+  // zuerst die Histogramme der HTTP-Handler, je Route ein Abschnitt
+  if (step < routeCount) {
+    if (step == 0) appendMetricHeader(out, "lightning_http_handler_us", "histogram", "Laufzeit der HTTP-Handler");
+    char labels[64];
+    snprintf(labels, sizeof(labels), "path=\"%s\"", routeStats[step].uri);
+    appendHistogram(out, "lightning_http_handler_us", labels, routeStats[step].h);
+    return true;
+  }
+  switch (step - routeCount) {
+    case 0:
+      appendMetricHeader(out, "lightning_isr_to_read_us", "histogram", "AS3935 IRQ bis Beginn des Registerlesens (inkl. 2 ms Wartezeit)");
+      appendHistogram(out, "lightning_isr_to_read_us", nullptr, mIsrToRead);
+      break;
+    case 1:
+      appendMetricHeader(out, "lightning_i2c_us", "histogram", "Dauer der I2C-Transaktionen zum AS3935");
+      appendHistogram(out, "lightning_i2c_us", "op=\"burst\"", mI2cBurst);
+      break;
+    case 2:
+      appendHistogram(out, "lightning_i2c_us", "op=\"poll\"", mI2cPoll);
+      break;
+    case 3:
+      appendMetricHeader(out, "lightning_json_serialize_us", "histogram", "JSON-Serialisierung");
+      appendHistogram(out, "lightning_json_serialize_us", "doc=\"live\"", mJsonLive);
+      break;
+    case 4:
+      appendHistogram(out, "lightning_json_serialize_us", "doc=\"stats\"", mJsonStats);
+      break;
+    case 5:
+      appendHistogram(out, "lightning_json_serialize_us", "doc=\"strike\"", mJsonStrike);
+      break;
+    case 6:
+      appendMetricHeader(out, "lightning_loop_us", "histogram", "Dauer eines loop()-Durchlaufs");
+      appendHistogram(out, "lightning_loop_us", nullptr, mLoop);
+      break;
+    case 7: {
+      appendMetricHeader(out, "lightning_loop_max_us", "gauge", "Längster loop()-Durchlauf seit Start");
+      appendMetricValue(out, "lightning_loop_max_us", nullptr, mLoop.peak());
+      appendMetricHeader(out, "lightning_i2c_errors_total", "counter", "Fehlgeschlagene I2C-Lesevorgänge");
+      appendMetricValue(out, "lightning_i2c_errors_total", nullptr, i2cErrors);
+      InterferenceCounts itot;
+      portENTER_CRITICAL(&interferenceMux);
+      itot = interference.totals();
+      portEXIT_CRITICAL(&interferenceMux);
+      appendMetricHeader(out, "lightning_interrupts_total", "counter", "AS3935-Interrupts nach Quelle");
+      appendMetricValue(out, "lightning_interrupts_total", "src=\"noise\"", itot.noise);
+      appendMetricValue(out, "lightning_interrupts_total", "src=\"disturber\"", itot.disturber);
+      break;
+  }
+  case 8: {
+    AfeSettings afe;
+    portENTER_CRITICAL(&interferenceMux);
+    afe = afeTuner.settings();
+    portEXIT_CRITICAL(&interferenceMux);
+    appendMetricHeader(out, "lightning_afe_setting", "gauge", "Aktuelle AS3935-Einstellungen (Nachführung)");
+    appendMetricValue(out, "lightning_afe_setting", "name=\"noise_level\"", afe.noiseLevel);
+    appendMetricValue(out, "lightning_afe_setting", "name=\"watchdog\"", afe.watchdog);
+    appendMetricValue(out, "lightning_afe_setting", "name=\"spike_rejection\"", afe.spike);
+    appendMetricValue(out, "lightning_afe_setting", "name=\"mask_disturber\"", afe.maskDisturber);
+    appendMetricHeader(out, "lightning_afe_register_writes_total", "counter", "I2C-Schreibzugriffe auf die AFE-Register 0x00..0x03");
+    appendMetricValue(out, "lightning_afe_register_writes_total", nullptr, afeRegisterWrites);
+    appendMetricHeader(out, "lightning_config_changes_total", "counter", "Übernommene Änderungen über /api/config");
+    appendMetricValue(out, "lightning_config_changes_total", nullptr, configChanges);
+    break;
+  }
+  case 9:
+    appendMetricHeader(out, "lightning_irq_edges_total", "counter", "Flanken am AS3935-IRQ-Pin");
+    appendMetricValue(out, "lightning_irq_edges_total", nullptr, irqGuard.edges());
+    appendMetricHeader(out, "lightning_irq_coalesced_total", "counter", "Flanken ohne eigenen Lesevorgang (zusammengefasst)");
+    appendMetricValue(out, "lightning_irq_coalesced_total", nullptr, irqGuard.coalesced());
+    appendMetricHeader(out, "lightning_irq_storms_total", "counter", "Erkannte IRQ-Stürme");
+    appendMetricValue(out, "lightning_irq_storms_total", nullptr, irqGuard.storms());
+    appendMetricHeader(out, "lightning_irq_storm_active", "gauge", "1 = Lesen gedrosselt, Disturber maskiert");
+    appendMetricValue(out, "lightning_irq_storm_active", nullptr, irqGuard.active());
+    break;
+  case 10:
+    appendMetricHeader(out, "lightning_heap_free_bytes", "gauge", "Freier Heap");
+    appendMetricValue(out, "lightning_heap_free_bytes", nullptr, ESP.getFreeHeap());
+    appendMetricHeader(out, "lightning_heap_min_free_bytes", "gauge", "Minimal freier Heap seit Start");
+    appendMetricValue(out, "lightning_heap_min_free_bytes", nullptr, ESP.getMinFreeHeap());
+    appendMetricHeader(out, "lightning_heap_largest_block_bytes", "gauge", "Größter zusammenhängender freier Block");
+    appendMetricValue(out, "lightning_heap_largest_block_bytes", nullptr, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+    break;
+  case 11: {
+    appendMetricHeader(out, "lightning_wifi_disconnects_total", "counter", "WLAN-Verbindungsabbrüche");
+    appendMetricValue(out, "lightning_wifi_disconnects_total", nullptr, wifiDisconnects);
+    appendMetricHeader(out, "lightning_wifi_reconnects_total", "counter", "Erfolgreiche Reconnects (GOT_IP nach Abbruch)");
+    appendMetricValue(out, "lightning_wifi_reconnects_total", nullptr, wifiReconnects);
+    appendMetricHeader(out, "lightning_wifi_rssi_dbm", "gauge", "Empfangsstärke");
+    char line[48];
+    snprintf(line, sizeof(line), "lightning_wifi_rssi_dbm %d\n", (int)WiFi.RSSI());
+    out += line;
+    portENTER_CRITICAL(&wifiMux);
+    const uint32_t wifiRetries = wifiBackoff.attempts();
+    const uint32_t wifiRetryMs = wifiBackoff.armed() ? wifiBackoff.delayMs() : 0;
+    portEXIT_CRITICAL(&wifiMux);
+    appendMetricHeader(out, "lightning_wifi_retries_total", "counter", "Verbindungsversuche des Supervisors");
+    appendMetricValue(out, "lightning_wifi_retries_total", nullptr, wifiRetries);
+    appendMetricHeader(out, "lightning_wifi_retry_delay_ms", "gauge", "Aktueller Backoff (0 = verbunden)");
+    appendMetricValue(out, "lightning_wifi_retry_delay_ms", nullptr, wifiRetryMs);
+    break;
+  }
+  case 12: {
+    size_t historySize;
+    {
+      HistoryLock lock;
+      historySize = history.size();
+    }
+    appendMetricHeader(out, "lightning_history_events", "gauge", "Einträge im RAM-Speicher");
+    appendMetricValue(out, "lightning_history_events", nullptr, historySize);
+    appendMetricHeader(out, "lightning_sensor_queue_drops_total", "counter", "Verworfene Messungen (Queue Sensor-Task → loop voll)");
+    appendMetricValue(out, "lightning_sensor_queue_drops_total", nullptr, sensorQueueDrops);
+    appendMetricHeader(out, "lightning_eventlog_pending", "gauge", "Noch nicht geschriebene Einträge");
+    appendMetricValue(out, "lightning_eventlog_pending", nullptr, eventLog.pending());
+    appendMetricHeader(out, "lightning_eventlog_dropped_total", "counter", "Nicht persistierte Einträge (Staging voll)");
+    appendMetricValue(out, "lightning_eventlog_dropped_total", nullptr, eventLog.dropped());
+    appendMetricHeader(out, "lightning_eventlog_write_errors_total", "counter", "Fehlgeschlagene Schreibversuche");
+    appendMetricValue(out, "lightning_eventlog_write_errors_total", nullptr, eventLog.writeErrors());
+    break;
+  }
+  case 13: {
+    portENTER_CRITICAL(&clockMux);
+    const uint32_t clockSyncs = eventClock.syncs();
+    const int64_t clockStep = eventClock.lastStepUs();
+    portEXIT_CRITICAL(&clockMux);
+    appendMetricHeader(out, "lightning_clock_syncs_total", "counter", "NTP-Synchronisationen");
+    appendMetricValue(out, "lightning_clock_syncs_total", nullptr, clockSyncs);
+    appendMetricHeader(out, "lightning_clock_last_step_us", "gauge", "Betrag der Korrektur bei der letzten Synchronisation");
+    appendMetricValue(out, "lightning_clock_last_step_us", nullptr, (unsigned long long)(clockStep < 0 ? -clockStep : clockStep));
+    appendMetricHeader(out, "lightning_uptime_seconds", "counter", "Laufzeit seit Start");
+    appendMetricValue(out, "lightning_uptime_seconds", nullptr, millis() / 1000);
+    appendMetricHeader(out, "lightning_reset_reason", "gauge", "esp_reset_reason() beim letzten Start");
+    appendMetricValue(out, "lightning_reset_reason", nullptr, (unsigned)esp_reset_reason());
+    break;
+  }
+  case 14:
+#ifdef MQTT_URI
+    appendMetricHeader(out, "lightning_mqtt_connected", "gauge", "1 = mit dem Broker verbunden");
+    appendMetricValue(out, "lightning_mqtt_connected", nullptr, mqttConnected);
+    appendMetricHeader(out, "lightning_mqtt_acked_seq", "gauge", "Letzte vom Broker bestätigte seq");
+    appendMetricValue(out, "lightning_mqtt_acked_seq", nullptr, mqttResume.ackedSeq);
+    appendMetricHeader(out, "lightning_mqtt_lost_total", "counter", "Blitze, die vor dem Senden aus History/Queue-Limit fielen");
+    appendMetricValue(out, "lightning_mqtt_lost_total", nullptr, mqttCursor.lost());
+    appendMetricHeader(out, "lightning_mqtt_errors_total", "counter", "MQTT-Fehler nach Art");
+    appendMetricValue(out, "lightning_mqtt_errors_total", "kind=\"enqueue\"", mqttEnqueueErrors);
+    appendMetricValue(out, "lightning_mqtt_errors_total", "kind=\"expired\"", mqttCursor.retries());
+#endif
+    break;
+  case 15:
+#ifdef STRIKE_BROADCAST
+    appendMetricHeader(out, "lightning_push_packets_total", "counter", "Blitz-Datagramme (Multicast)");
+    appendMetricValue(out, "lightning_push_packets_total", "dir=\"sent\"", strikePacketsSent);
+    appendMetricValue(out, "lightning_push_packets_total", "dir=\"received\"", strikePacketsReceived);
+    appendMetricHeader(out, "lightning_push_errors_total", "counter", "Nicht gesendete bzw. ungültige Datagramme");
+    appendMetricValue(out, "lightning_push_errors_total", "kind=\"send\"", strikeSendErrors);
+    appendMetricValue(out, "lightning_push_errors_total", "kind=\"invalid\"", strikePacketsInvalid);
+#endif
+#ifdef OTA_PASSWORD
+    appendMetricHeader(out, "lightning_ota_bytes", "gauge", "Geschriebene Bytes des laufenden bzw. letzten Updates");
+    appendMetricValue(out, "lightning_ota_bytes", nullptr, otaBytes);
+    appendMetricHeader(out, "lightning_ota_failures_total", "counter", "Fehlgeschlagene oder abgebrochene Updates");
+    appendMetricValue(out, "lightning_ota_failures_total", nullptr, otaFailures);
+#endif
+    break;
+  case 16:
+    appendMetricHeader(out, "lightning_ota_pending_verify", "gauge", "1 = neues Image noch nicht bestätigt");
+    appendMetricValue(out, "lightning_ota_pending_verify", nullptr, otaHealth.pending());
+    appendMetricHeader(out, "lightning_sensor_ok", "gauge", "1 = AS3935 initialisiert und plausibel");
+    appendMetricValue(out, "lightning_sensor_ok", nullptr, AS3935_started);
+    appendMetricHeader(out, "lightning_sensor_check_failures_total", "counter", "Fehlgeschlagene Registerprüfungen des AS3935");
+    appendMetricValue(out, "lightning_sensor_check_failures_total", nullptr, sensorCheckFailures);
+    appendMetricHeader(out, "lightning_sensor_recoveries_total", "counter", "I2C-Bus freigetaktet und AS3935 neu initialisiert");
+    appendMetricValue(out, "lightning_sensor_recoveries_total", nullptr, sensorRecoveries);
+    break;
+  case 17:
+    appendMetricHeader(out, "lightning_task_wdt_active", "gauge", "1 = Supervisor vom Task-Watchdog überwacht");
+    appendMetricValue(out, "lightning_task_wdt_active", nullptr, taskWdtActive);
+    appendMetricHeader(out, "lightning_supervisor_restarts_total", "counter", "Kontrollierte Neustarts nach Grund (seit dem Einschalten)");
+    for (uint8_t r = 0; r < RESTART_REASONS; ++r) {
+      appendMetricValue(out, "lightning_supervisor_restarts_total", RESTART_REASON_LABELS[r], restartLog.count[r]);
+    }
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
 
-  uint32_t cnt = 0;
-  uint32_t near=0, mid=0, far_=0, oor=0;
+static void handleMetrics(HttpRequest* req) {
+  // eigene Sperren je Abschnitt, nicht die HistoryLock von sendStream()
+  sendStream<MetricsStream<METRICS_CHUNK_MAX>, NoStreamLock>(req, "text/plain; version=0.0.4", renderMetrics);
+}
 
-  for (const auto &e : history) {
-    if (e.ts < cutoff) continue;
-    cnt++;
-    if (e.distance == 63) oor++;
-    else if (e.distance <= 5) near++;
-    else if (e.distance <= 15) mid++;
-    else far_++;
+// =============================
+// Laufzeit-Konfiguration: NVS und /api/config
+// =============================
+// Fehlende Schlüssel behalten die Vorgabe; ist das Ergebnis ungültig (z. B. HISTORY_MAX
+// verkleinert), gilt CONFIG_DEFAULT
+static void loadConfig() {
+  DeviceConfig c = CONFIG_DEFAULT;
+  Preferences prefs;
+  if (prefs.begin(CONFIG_NVS_NAMESPACE, true)) {
+    for (const ConfigField& f : CONFIG_FIELDS) {
+      f.set(c, prefs.getUInt(f.key, f.get(c)));
+    }
+    prefs.end();
   }
+  if (const char* bad = validateConfig(c, HISTORY_MAX)) {
+#ifdef SERIALDEBUG
+    Serial.printf("Konfiguration im NVS ungueltig (%s), Vorgaben aktiv\n", bad);
+#else
+    (void)bad;
+#endif
+    c = CONFIG_DEFAULT;
+  }
+  portENTER_CRITICAL(&configMux);
+  config = c;
+  portEXIT_CRITICAL(&configMux);
+  afeTuner.setBase(c.afe); // Sensor-Task läuft noch nicht
+}
+
+// Nur die geänderten Felder schreiben (Flash-Verschleiß); false = NVS nicht beschreibbar
+static bool saveConfig(const DeviceConfig& c, uint32_t changed) {
+  Preferences prefs;
+  if (!prefs.begin(CONFIG_NVS_NAMESPACE, false)) return false;
+  bool ok = true;
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; ++i) {
+    if (!(changed & 1u << i)) continue;
+    const ConfigField& f = CONFIG_FIELDS[i];
+    ok = prefs.putUInt(f.key, f.get(c)) == sizeof(uint32_t) && ok;
+  }
+  prefs.end();
+  return ok;
+}
 
+static void sendConfig(HttpRequest* req, const DeviceConfig& c, uint32_t changed) {
   DynamicJsonDocument doc(1024);
-  doc["range_s"] = sinceSec;
-  doc["count"] = cnt;
-  JsonObject b = doc.createNestedObject("buckets");
-  b["near_<=5km"] = near;
-  b["mid_6-15km"] = mid;
-  b[">15km"] = far_;
-  b["out_of_range"] = oor;
+  for (size_t i = 0; i < CONFIG_FIELD_COUNT; ++i) {
+    const ConfigField& f = CONFIG_FIELDS[i];
+    if (f.isBool) doc[f.key] = f.get(c) != 0;
+    else doc[f.key] = f.get(c);
+  }
+  doc["history_capacity"] = HISTORY_MAX;
+  if (changed) {
+    JsonArray a = doc.createNestedArray("changed");
+    for (size_t i = 0; i < CONFIG_FIELD_COUNT; ++i) {
+      if (changed & 1u << i) a.add(CONFIG_FIELDS[i].key);
+    }
+  }
+  String out;
+  serializeJson(doc, out);
+  req->send(200, "application/json", out);
+}
+
+static void sendConfigError(HttpRequest* req, const char* msg, const char* key) {
+  DynamicJsonDocument doc(256);
+  doc["error"] = msg;
+  doc["field"] = key;
+  String out;
+  serializeJson(doc, out);
+  req->send(400, "application/json", out);
+}
+
+// GET: aktuelle Werte. POST mit Parametern (Query oder Formular, z. B.
+// curl -d noise_level=3 -d indoor=false …/api/config): nur die angegebenen Felder ändern.
+// Alles wird geprüft, bevor irgendetwas gilt; danach sofort aktiv (Sensor-Task per
+// NOTIFY_CONFIG, loop() beim nächsten Durchlauf) und im NVS gespeichert.
+static void handleConfig(HttpRequest* req) {
+  if (req->method() != HTTP_POST) {
+    sendConfig(req, configSnapshot(), 0);
+    return;
+  }
+  const DeviceConfig cur = configSnapshot();
+  DeviceConfig next = cur;
+  for (const ConfigField& f : CONFIG_FIELDS) {
+    if (!req->hasArg(f.key)) continue;
+    const String v = req->arg(f.key);
+    uint32_t n;
+    if (f.isBool && (v == "true" || v == "false")) {
+      n = v == "true";
+    } else {
+      char* end = nullptr;
+      const unsigned long parsed = strtoul(v.c_str(), &end, 0);
+      if (v.isEmpty() || *end || v[0] == '-') {
+        sendConfigError(req, "keine Zahl", f.key);
+        return;
+      }
+      n = parsed > UINT32_MAX ? UINT32_MAX : (uint32_t)parsed;
+    }
+    f.set(next, n);
+    if (f.get(next) != n) { // abgeschnitten (uint8_t-Feld)
+      sendConfigError(req, "ausserhalb der Grenzen", f.key);
+      return;
+    }
+  }
+  if (const char* bad = validateConfig(next, HISTORY_MAX)) {
+    sendConfigError(req, "ausserhalb der Grenzen", bad);
+    return;
+  }
+  const uint32_t changed = configDiff(cur, next);
+  if (changed) {
+    portENTER_CRITICAL(&configMux);
+    config = next;
+    configChanges++;
+    portEXIT_CRITICAL(&configMux);
+    if (sensorTaskHandle) xTaskNotify(sensorTaskHandle, NOTIFY_CONFIG, eSetBits);
+    if (!saveConfig(next, changed)) {
+      // gilt trotzdem bis zum nächsten Neustart
+#ifdef SERIALDEBUG
+      Serial.println("Konfiguration nicht im NVS gespeichert");
+#endif
+    }
+  }
+  sendConfig(req, next, changed);
+}
+
+// =============================
+// Sensor-Task
+// =============================
+// AS3935-Analogteil einstellen (nur aus dem Sensor-Task bzw. vor dessen Start, wegen I2C).
+// Direkt über Wire statt über die Setter der Lib: nur geänderte Register, ohne Lesen vorher
+// (Abbild afeRegs, siehe device_config.h).
+static AfeRegisters afeRegs = {};
+
+static void applyAfeSettings(bool indoor, const AfeSettings& a) {
+  const AfeRegisters next = afeRegisterImage(afeRegs, indoor, a);
+  const uint8_t changed = afeRegistersChanged(afeRegs, next);
+  for (uint8_t r = 0; r < AFE_REG_COUNT; ++r) {
+    if (!(changed & 1u << r)) continue;
+    Wire.beginTransmission(AS3935_I2C_ADDR);
+    Wire.write(r);
+    Wire.write(next.reg[r]);
+    if (Wire.endTransmission() == 0) {
+      afeRegs.reg[r] = next.reg[r];
+      afeRegisterWrites++;
+    }
+  }
+}
+
+// n Register ab first in einer Transaktion (der AS3935 zählt die Adresse selbst hoch).
+// false = Bus-Fehler, buf bleibt dann 0.
+static bool readAs3935(uint8_t first, uint8_t* buf, uint8_t n) {
+  memset(buf, 0, n);
+  Wire.beginTransmission(AS3935_I2C_ADDR);
+  Wire.write(first);
+  if (Wire.endTransmission(false) != 0 || Wire.requestFrom(AS3935_I2C_ADDR, n) != n) {
+    i2cErrors++;
+    return false;
+  }
+  for (uint8_t i = 0; i < n; ++i) buf[i] = Wire.read();
+  return true;
+}
+
+static void readAfeRegisters() {
+  uint8_t raw[AFE_REG_COUNT];
+  readAs3935(0x00, raw, AFE_REG_COUNT);
+  afeRegs = afeRegistersFrom(raw);
+}
+
+// Hängt der AS3935 mitten in einem Byte (SDA low), gibt er den Bus erst nach weiteren Takten
+// frei: bis zu 9 Takte auf SCL, danach eine STOP-Bedingung. Wire muss danach neu starten.
+static void clearI2cBus() {
+  Wire.end();
+  pinMode(PIN_I2C_SDA, INPUT_PULLUP);
+  pinMode(PIN_I2C_SCL, OUTPUT_OPEN_DRAIN);
+  digitalWrite(PIN_I2C_SCL, HIGH);
+  delayMicroseconds(5);
+  for (int i = 0; i < 9 && digitalRead(PIN_I2C_SDA) == LOW; ++i) {
+    digitalWrite(PIN_I2C_SCL, LOW);
+    delayMicroseconds(5);
+    digitalWrite(PIN_I2C_SCL, HIGH);
+    delayMicroseconds(5);
+  }
+  pinMode(PIN_I2C_SDA, OUTPUT_OPEN_DRAIN); // STOP: SDA low → high, während SCL high ist
+  digitalWrite(PIN_I2C_SDA, LOW);
+  delayMicroseconds(5);
+  digitalWrite(PIN_I2C_SDA, HIGH);
+  delayMicroseconds(5);
+  pinMode(PIN_I2C_SDA, INPUT);
+  pinMode(PIN_I2C_SCL, INPUT);
+}
+
+static bool initAS3935();
+
+// Auf NOTIFY_CHECK: stimmen 0x00..0x02 noch mit dem Abbild überein (0x03 nicht, das Lesen
+// würde einen anstehenden Interrupt quittieren, siehe AFE_CHECK_COUNT)? Bus-Fehler, 0xFF (Bus
+// hängt) oder zurückgesetzte Register (Spannungseinbruch) zählen als Fehlschlag; nach
+// SENSOR_CHECK_FAILS in Folge bzw. solange der Sensor nicht läuft: Bus freitakten und neu
+// initialisieren. true = neu initialisiert, aktuelle AFE-Werte müssen wieder hinein.
+static FailureStreak sensorCheckStreak(SENSOR_CHECK_FAILS);
+
+static bool checkSensor() {
+  uint8_t raw[AFE_CHECK_COUNT];
+  const bool ok = AS3935_started && readAs3935(0x00, raw, AFE_CHECK_COUNT)
+               && afeRegistersMatch(afeRegs, raw);
+  if (!ok) sensorCheckFailures++;
+  if (!sensorCheckStreak.report(ok) && AS3935_started) return false;
+#ifdef SERIALDEBUG
+  Serial.println("AS3935 antwortet nicht plausibel: Bus freitakten, neu initialisieren");
+#endif
+  detachInterrupt(digitalPinToInterrupt(PIN_AS3935_IRQ));
+  clearI2cBus();
+  sensorRecoveries++;
+  if (!initAS3935()) return false;
+  // Steht der IRQ-Pin schon high, käme keine Flanke mehr: gleich lesen
+  if (digitalRead(PIN_AS3935_IRQ) == HIGH) xTaskNotify(sensorTaskHandle, NOTIFY_IRQ, eSetBits);
+  return true;
+}
+
+// Messung an loop() übergeben; wartet loop() gerade (LOW_POWER), wird es sofort geweckt
+static void queueForLoop(const LightningEvent& ev) {
+  if (!sensorQueue.push(ev)) {
+    sensorQueueDrops++;
+    return;
+  }
+  if (loopTaskHandle) xTaskNotifyGive(loopTaskHandle);
+}
+
+static void sensorTask(void*) {
+  uint32_t tLastStrike = 0;
+  bool pollPending = false; // Distanz cfg.pollMs nach dem letzten Blitz nachlesen
+  uint32_t tLastRead = 0;
+  uint32_t seenEdges = 0;
+  bool trendUnix = clockValid; // Zeitbasis des Trends
+  DeviceConfig cfg = configSnapshot();
+
+  for (;;) {
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, pdMS_TO_TICKS(1000));
+    sensorBeat = sensorBeat + 1;
+    bool strike = false;
+    LightningEvent strikeEv = {};
+
+#ifdef LOW_POWER
+    if (bits & NOTIFY_IRQ) esp_pm_lock_acquire(sensorPmLock);
+#endif
+    if (bits & NOTIFY_IRQ) {
+      // Min. 2ms Delay between interrupt goes high and read the register
+      // (+1 Tick, da vTaskDelay die laufende Tick-Periode mitzählt). Im Sturm zusätzlich bis
+      // IrqStormGuard::READ_GAP_MS seit dem letzten Lesen warten; Flanken in dieser Zeit
+      // werden mit dem einen Lesevorgang erledigt.
+      vTaskDelay(pdMS_TO_TICKS(2 + irqGuard.readDelayMs(millis(), tLastRead)) + 1);
+      uint32_t more = 0;
+      if (xTaskNotifyWait(0, UINT32_MAX, &more, 0) == pdTRUE) bits |= more;
+      mIsrToRead.observe(cyclesToUs(esp_cpu_get_ccount() - isrCycles));
+      const uint32_t edges = isrEdges;
+      portENTER_CRITICAL(&isrMux);
+      const int64_t irqUs = isrTimePending ? isrTimeUs : esp_timer_get_time();
+      isrTimePending = false; // Flanken ab hier gehören zum nächsten Lesevorgang
+      portEXIT_CRITICAL(&isrMux);
+      // Interruptquelle, Energie und Distanz in einem Burst (as3935_burst.h); Energie und
+      // Distanz werden nur bei Ereignissen aus cfg.eventMask verwendet
+      uint8_t regs[AS3935_BURST_LEN];
+      {
+        ScopeTimer t(mI2cBurst);
+        readAs3935(AS3935_REG_INT, regs, AS3935_BURST_LEN);
+      }
+      const As3935Reading rd = decodeAs3935Burst(regs);
+      const uint8_t intSrc = rd.intSrc;
+      tLastRead = millis();
+#ifdef LOW_POWER
+      gpio_wakeup_enable((gpio_num_t)PIN_AS3935_IRQ, GPIO_INTR_HIGH_LEVEL); // wieder scharf
+#endif
+      irqGuard.onRead(tLastRead, edges != seenEdges ? edges - seenEdges : 1);
+      seenEdges = edges;
+      // 0 = keine, 1 = Noise, 4 = Disturber, 8 = Lightning (abhängig von Lib – Doku prüfen)
+
+      LightningEvent ev = {0, 63, 0, intSrc, true};
+      setEventTime(ev, stampUs(irqUs));
+      ev.monoUs = irqUs;
+      pipeline.setLastEvent(intSrc);
+      if (intSrc & (INT_NOISE | INT_DISTURBER)) {
+        // Nur zählen: Störer-Stürme (z. B. Wechselrichter) fluten so weder Queue noch loop()
+        portENTER_CRITICAL(&interferenceMux);
+        interference.add(ev.ts, intSrc);
+        portEXIT_CRITICAL(&interferenceMux);
+      }
+      if (intSrc & cfg.eventMask) {
+        ev.distance = rd.distance; // 1..63 km, 0 = sehr nahe, 63 = out of range
+        ev.energy = rd.energy;
+        strike = true;
+        strikeEv = ev;
+        tLastStrike = millis();
+        pollPending = true;
+      }
+      if (intSrc & cfg.eventMask) queueForLoop(ev);
+    }
+
+    // Neue Konfiguration (/api/config): Ausgangswerte geändert → Nachführung beginnt neu
+    bool reconfigure = false;
+    if (bits & NOTIFY_CONFIG) {
+      const DeviceConfig next = configSnapshot();
+      reconfigure = true;
+      if (!(next.afe == cfg.afe)) {
+        portENTER_CRITICAL(&interferenceMux);
+        afeTuner.setBase(next.afe);
+        portEXIT_CRITICAL(&interferenceMux);
+      }
+      cfg = next;
+    }
+    if ((bits & NOTIFY_CHECK) && checkSensor()) reconfigure = true;
+
+    // Sturmschutz und Empfindlichkeit nachführen (höchstens ein Schritt pro
+    // AfeAutoTuner::COOLDOWN_SEC); maskDisturber gilt, sobald einer von beiden es verlangt
+    const bool stormChanged = irqGuard.update(millis());
+    portENTER_CRITICAL(&interferenceMux);
+#ifndef AFE_NO_AUTOTUNE
+    const bool retune = AS3935_started && afeTuner.evaluate(eventNow(), interference);
+#else
+    const bool retune = false;
+#endif
+    AfeSettings afe = afeTuner.settings();
+    portEXIT_CRITICAL(&interferenceMux);
+    afe.maskDisturber = afe.maskDisturber || irqGuard.active();
+    if ((retune || reconfigure) && AS3935_started) {
+      applyAfeSettings(cfg.indoor, afe);
+#ifdef SERIALDEBUG
+      Serial.printf("AFE nachgeführt: noise %u, watchdog %u, spike %u, mask %d\n",
+                    afe.noiseLevel, afe.watchdog, afe.spike, afe.maskDisturber);
+#endif
+    } else if (stormChanged && AS3935_started) {
+      applyAfeSettings(cfg.indoor, afe); // schreibt nur 0x03 (MASK_DIST)
+#ifdef SERIALDEBUG
+      Serial.printf(irqGuard.active() ? "IRQ-Sturm (%u/s): Disturber maskiert\n"
+                                      : "IRQ-Sturm vorbei (%u/s)\n", (unsigned)irqGuard.lastRate());
+#endif
+    }
+
+    // Trend fortschreiben (bzw. nur altern lassen) und die LEDs sofort danach stellen,
+    // nicht erst wenn loop() die Queue leert
+    const time_t now = eventNow();
+    portENTER_CRITICAL(&trendMux);
+    if (clockValid && !trendUnix) {
+      trend.rebase(clockOffsetSec()); // erste NTP-Synchronisation: Sekunden seit Boot → Unix-Zeit
+      trendUnix = true;
+    }
+    if (strike) trend.update(strikeEv.ts, strikeEv.distance);
+    else trend.advance(now);
+    const TrendSnapshot t = trend.snapshot(now);
+    portEXIT_CRITICAL(&trendMux);
+#ifdef STRIKE_BROADCAST
+    showLeds(ledsForTrend(t, nearestPeerKm(now)));
+#else
+    showLeds(ledsForTrend(t));
+#endif
+
+    // Einmal cfg.pollMs nach dem letzten Blitz die Distanzschätzung nachlesen. Geht als
+    // Sample (irq = false, event = 0) an loop(), nicht in die History.
+    if (pollPending && millis() - tLastStrike >= cfg.pollMs) {
+      pollPending = false;
+      LightningEvent ev = {0, 0, 0, 0, false};
+      ev.monoUs = esp_timer_get_time();
+      setEventTime(ev, stampUs(ev.monoUs));
+      uint8_t regs[AS3935_POLL_LEN];
+      {
+        ScopeTimer t(mI2cPoll);
+        readAs3935(AS3935_REG_ENERGY, regs, AS3935_POLL_LEN);
+      }
+      As3935Reading rd;
+      decodeAs3935Measurement(regs, rd);
+      ev.distance = rd.distance;
+      ev.energy = rd.energy;
+      queueForLoop(ev);
+    }
+#ifdef LOW_POWER
+    if (bits & NOTIFY_IRQ) esp_pm_lock_release(sensorPmLock);
+#endif
+  }
+}
+
+// Nach der ersten NTP-Synchronisation: zurückgehaltene Blitze und Samples nachtragen
+static void flushUnsyncedEvents() {
+  const size_t n = pipeline.flushUnsynced(clockOffsetSec());
+#ifdef SERIALDEBUG
+  Serial.printf("Uhrzeit gesetzt, %u Ereignisse nachgetragen\n", (unsigned)n);
+#else
+  (void)n;
+#endif
+}
+
+// Vom Sensor-Task gelieferte Messung übernehmen (läuft in loop()). Noise/Disturber kommen hier
+// nur an, wenn config.eventMask sie enthält, siehe interference
+static void handleSensorEvent(const LightningEvent& ev) {
+#ifdef SERIALDEBUG
+  if (!ev.irq) Serial.printf("regular data polling: Distanz %u km\n", ev.distance);
+  else if (ev.event & 0x08) Serial.printf("⚡ Blitz erkannt: Distanz %u km, Energy %lu\n", ev.distance, (unsigned long)ev.energy);
+#endif
+  pipeline.handle(ev, configSnapshot().eventMask, millis());
+}
+
+#ifdef MQTT_URI
+// =============================
+// MQTT
+// =============================
+// Der Client (esp-mqtt) läuft in einem eigenen Task; loop() übergibt Nachrichten nur mit
+// esp_mqtt_client_enqueue (blockiert nicht auf das Netz). Blitze gehen mit QoS 1 nach
+// MQTT_TOPIC/strike, die History ist die Offline-Queue (PublishCursor, mqtt_outbox.h).
+// live/trend gehen retained mit QoS 0, status ist "online" bzw. als Last Will "offline".
+
+static void onMqttEvent(void*, esp_event_base_t, int32_t id, void* data) {
+  const esp_mqtt_event_handle_t ev = (esp_mqtt_event_handle_t)data;
+  switch ((esp_mqtt_event_id_t)id) {
+    case MQTT_EVENT_CONNECTED:
+      mqttConnected = true;
+      mqttSessions = mqttSessions + 1;
+      break;
+    case MQTT_EVENT_DISCONNECTED:
+      mqttConnected = false;
+      break;
+    case MQTT_EVENT_PUBLISHED:
+      mqttAcks.push(MqttAck{ev->msg_id, true});
+      break;
+    case MQTT_EVENT_DELETED:
+      mqttAcks.push(MqttAck{ev->msg_id, false});
+      break;
+    default:
+      break;
+  }
+}
+
+// Nach restoreHistory(): der Cursor braucht die zurückgespielten Sequenznummern
+static void setupMqtt() {
+  const uint32_t head = history.headSeq();
+  const bool resume = mqttResume.magic == MQTT_RESUME_MAGIC && (int32_t)(head - mqttResume.ackedSeq) >= 0;
+  mqttCursor.start(resume ? mqttResume.ackedSeq : head); // Kaltstart: nur neue Blitze
+
+  esp_mqtt_client_config_t cfg = {};
+  cfg.broker.address.uri = MQTT_URI;
+#ifdef MQTT_USER
+  cfg.credentials.username = MQTT_USER;
+  cfg.credentials.authentication.password = MQTT_PASSWORD;
+#endif
+  cfg.session.last_will.topic = MQTT_TOPIC "/status";
+  cfg.session.last_will.msg = "offline";
+  cfg.session.last_will.qos = 1;
+  cfg.session.last_will.retain = 1;
+  mqtt = esp_mqtt_client_init(&cfg);
+  if (!mqtt) return;
+  esp_mqtt_client_register_event(mqtt, MQTT_EVENT_ANY, onMqttEvent, nullptr);
+  esp_mqtt_client_start(mqtt); // verbindet selbst, sobald das WLAN steht, inkl. Reconnect
+}
+
+static void mqttEnqueue(const char* topic, const char* payload, size_t len, int qos, bool retain) {
+  if (esp_mqtt_client_enqueue(mqtt, topic, payload, len, qos, retain, true) < 0) mqttEnqueueErrors++;
+}
 
-  String out; serializeJson(doc, out);
-  server.send(200, "application/json", out);
+static void publishMqttState(const TrendSnapshot& t) {
+  char buf[384];
+  DynamicJsonDocument doc(512);
+  fillTrendJson(doc, t);
+  mqttEnqueue(MQTT_TOPIC "/trend", buf, serializeJson(doc, buf, sizeof(buf)), 0, true);
+
+  doc.clear();
+  const LiveState live = pipeline.live();
+  doc["ts"] = (int64_t)eventNow();
+  doc["last_distance_km"] = live.distance;
+  doc["last_energy"] = live.energy;
+  doc["last_event_ts"] = (int64_t)live.eventTs;
+  doc["leds"] = ledMask;
+  doc["level_name"] = alertLevelName(t.level);
+  doc["uptime_s"] = (uint32_t)(millis() / 1000);
+  mqttEnqueue(MQTT_TOPIC "/live", buf, serializeJson(doc, buf, sizeof(buf)), 0, true);
+}
+
+// Läuft in loop(): Bestätigungen einsammeln, Zustand bei Änderungen melden, Blitze aus der
+// History nachschieben (höchstens PublishCursor::MAX_INFLIGHT offen, gedrosselt per mqttRate)
+static void mqttLoop() {
+  MqttAck a;
+  while (mqttAcks.pop(a)) {
+    if (a.ok) mqttCursor.acked(a.msgId);
+    else mqttCursor.failed(a.msgId);
+  }
+  mqttResume.ackedSeq = mqttCursor.ackedSeq();
+  mqttResume.magic = MQTT_RESUME_MAGIC;
+  if (!mqtt || !mqttConnected) return;
+
+  static uint32_t session = 0;
+  static uint32_t lastStateMs = 0;
+  static uint8_t lastLevel = 0xFF, lastLeds = 0xFF;
+  const uint32_t nowMs = millis();
+  const bool newSession = session != mqttSessions;
+  if (newSession) {
+    session = mqttSessions;
+    mqttEnqueue(MQTT_TOPIC "/status", "online", 6, 1, true);
+  }
+  const TrendSnapshot t = trendSnapshot(eventNow());
+  const bool changed = t.level != lastLevel || ledMask != lastLeds;
+  if (newSession || nowMs - lastStateMs >= MQTT_STATE_INTERVAL_MS
+      || (changed && nowMs - lastStateMs >= MQTT_STATE_MIN_MS)) {
+    lastStateMs = nowMs;
+    lastLevel = t.level;
+    lastLeds = ledMask;
+    publishMqttState(t);
+  }
+
+  for (;;) {
+    uint32_t seq, oldest, head;
+    {
+      HistoryLock lock;
+      head = history.headSeq();
+      oldest = history.empty() ? head + 1 : history.seqOf(history.beginPos());
+    }
+    if (head >= MQTT_QUEUE_MAX && oldest < head - MQTT_QUEUE_MAX + 1) oldest = head - MQTT_QUEUE_MAX + 1;
+    if (!mqttCursor.next(oldest, head, seq) || !mqttRate.take(nowMs)) break;
+
+    LightningEvent e;
+    bool have;
+    uint32_t found;
+    {
+      HistoryLock lock;
+      const uint32_t pos = history.posAfter(seq - 1);
+      have = history.validPos(pos);
+      found = have ? history.seqOf(pos) : head;
+      have = have && found == seq;
+      if (have) e = history.atPos(pos);
+    }
+    // Lücke in den Sequenznummern (Neustart): bis vor den nächsten vorhandenen Eintrag springen
+    if (!have) { mqttCursor.skip(found == seq ? seq : found - 1); continue; }
+    char buf[160];
+    const size_t n = formatEventJson(buf, sizeof(buf), e, seq);
+    const int id = esp_mqtt_client_enqueue(mqtt, MQTT_TOPIC "/strike", buf, n, 1, false, true);
+    if (id < 0) { mqttEnqueueErrors++; break; } // Outbox voll: im nächsten Durchlauf wieder
+    mqttCursor.sent(id, seq);
+  }
+}
+#endif
+
+// =============================
+// OTA-Update
+// =============================
+// POST /api/ota (multipart, z. B. curl -u ota:<Passwort> -F image=@firmware.bin …/api/ota):
+// Update schreibt die Chunks direkt in die inaktive App-Partition, die Firmware liegt nie
+// ganz im RAM. Der Sensor-Task liest weiter; der synchrone WebServer blockiert loop() für
+// die Dauer des Uploads, deshalb wird die Sensor-Queue dann pro Chunk geleert. Nach Erfolg
+// startet loop() neu, vorher schreibt flushLogBeforeReboot() die Staging-Seiten.
+#ifdef OTA_PASSWORD
+static void drainSensorQueue(); // loop()
+
+static void otaAbort() {
+  Update.abort();
+  otaOwner = nullptr;
+  otaFailures++;
+}
+
+static void otaChunk(HttpRequest* req, bool first, const uint8_t* data, size_t len, bool final) {
+#ifdef LOW_POWER
+  lastRequestMs = millis(); // kein Modem-Sleep während des Uploads
+#endif
+  if (first) {
+    // ohne Passwort oder während eines anderen Uploads: Daten verwerfen, Antwort in handleOtaDone
+    if (!req->authenticate(OTA_USER, OTA_PASSWORD) || otaOwner || otaRestartAtMs) return;
+    otaOwner = req;
+    otaFinished = nullptr;
+    otaBytes = 0;
+    otaError = "";
+    if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH)) otaError = Update.errorString();
+  }
+  if (req != otaOwner) return;
+  if (otaError.isEmpty() && len) {
+    if (Update.write((uint8_t*)data, len) == len) otaBytes += len;
+    else otaError = Update.errorString();
+  }
+  if (final) {
+    if (otaError.isEmpty() && !Update.end(true)) otaError = Update.errorString();
+    if (otaError.isEmpty()) otaOwner = nullptr;
+    else otaAbort();
+    otaFinished = req;
+  }
+#ifndef USE_ASYNC_WEBSERVER
+  drainSensorQueue(); // loop() steht, solange der Upload läuft
+#endif
+}
+
+// Nach dem letzten Chunk
+static void handleOtaDone(HttpRequest* req) {
+  if (!req->authenticate(OTA_USER, OTA_PASSWORD)) {
+    req->requestAuthentication();
+    return;
+  }
+  if (req == otaOwner) { // Upload ohne letzten Chunk
+    otaAbort();
+    req->send(500, "text/plain", "Upload unvollstaendig");
+    return;
+  }
+  if (req != otaFinished) {
+    if (otaOwner || otaRestartAtMs) req->send(409, "text/plain", "Update laeuft bereits");
+    else req->send(400, "text/plain", "kein Image");
+    return;
+  }
+  otaFinished = nullptr;
+  if (!otaError.isEmpty()) {
+    req->send(500, "text/plain", otaError);
+    return;
+  }
+  req->send(200, "text/plain", "OK, Neustart");
+  otaRestartAtMs = millis() + OTA_RESTART_DELAY_MS;
+  if (!otaRestartAtMs) otaRestartAtMs = 1;
+}
+
+static void setupOta() {
+#ifdef USE_ASYNC_WEBSERVER
+  server.on("/api/ota", HTTP_POST, handleOtaDone,
+            [](AsyncWebServerRequest* req, const String&, size_t index, uint8_t* data, size_t len, bool final) {
+              otaChunk(req, index == 0, data, len, final);
+            });
+#else
+  server.on("/api/ota", HTTP_POST, []() { handleOtaDone(&server); }, []() {
+    HTTPUpload& up = server.upload();
+    if (up.status == UPLOAD_FILE_START) otaChunk(&server, true, nullptr, 0, false);
+    else if (up.status == UPLOAD_FILE_WRITE) otaChunk(&server, false, up.buf, up.currentSize, false);
+    else if (up.status == UPLOAD_FILE_END) otaChunk(&server, false, nullptr, 0, true);
+    else if (up.status == UPLOAD_FILE_ABORTED && otaOwner) otaAbort();
+  });
+#endif
+}
+#endif
+
+// Mit Rollback-fähigem Bootloader startet ein neues Image als „pending verify“. Arduino
+// bestätigt dann nicht selbst (verifyRollbackLater), das macht otaVerify() nach der Prüfung.
+extern "C" bool verifyRollbackLater() { return true; }
+
+static void startOtaVerify() {
+  esp_ota_img_states_t state;
+  if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) != ESP_OK) return;
+  if (state == ESP_OTA_IMG_PENDING_VERIFY) otaHealth.start(millis());
+}
+
+// Gesund = Sensor antwortet und WLAN verbunden
+static void otaVerify() {
+  if (!otaHealth.pending()) return;
+  switch (otaHealth.update(millis(), AS3935_started && WiFi.status() == WL_CONNECTED)) {
+    case OtaHealthCheck::Verdict::Valid:
+      esp_ota_mark_app_valid_cancel_rollback();
+#ifdef SERIALDEBUG
+      Serial.println("OTA: neues Image bestaetigt");
+#endif
+      break;
+    case OtaHealthCheck::Verdict::Rollback:
+#ifdef SERIALDEBUG
+      Serial.println("OTA: Gesundheitspruefung fehlgeschlagen, Rollback");
+#endif
+      flushLogBeforeReboot();
+      esp_ota_mark_app_invalid_rollback_and_reboot(); // startet das vorige Image
+      break;
+    case OtaHealthCheck::Verdict::Wait:
+      break;
+  }
+}
+
+// =============================
+// Supervisor
+// =============================
+// Eigener Task, damit er auch dann läuft, wenn loop() oder der Sensor-Task hängen. Er füttert
+// den Task-Watchdog; hängt er selbst, löst der Watchdog den Reset aus.
+//   Herzschlag: Sensor-Task bzw. loop() TASK_STALL_MS ohne Fortschritt → Neustart
+//   AS3935: alle SENSOR_CHECK_MS Registerprüfung im Sensor-Task (checkSensor), ohne
+//           Sensor-Task (beim Start nicht gefunden) initAS3935 direkt
+//   WLAN: Wiederholung mit Backoff, solange getrennt (scharf geschaltet von onWiFiEvent)
+//   Heap: HEAP_LOW_CHECKS s in Folge unter den Schwellen → Neustart, bevor Allokationen scheitern
+// Neustarts laufen über esp_restart(); vorher schreibt flushLogBeforeReboot() die Staging-Seiten
+// (hängt der Schreib-Task selbst, nach LOG_REBOOT_FLUSH_MS ohne – weit unter dem Task-Watchdog).
+static void controlledRestart(RestartReason reason) {
+  restartLog.count[reason]++;
+  flushLogBeforeReboot();
+#ifdef SERIALDEBUG
+  Serial.printf("Supervisor: Neustart (%s)\n", RESTART_REASON_LABELS[reason]);
+  Serial.flush();
+#endif
+  esp_restart();
+}
+
+static void supervisorTask(void*) {
+  // Arduino startet den Task-Watchdog normalerweise selbst (Idle-Task); sonst hier
+  esp_err_t err = esp_task_wdt_add(nullptr);
+  if (err == ESP_ERR_INVALID_STATE) {
+    esp_task_wdt_config_t wdt = {};
+    wdt.timeout_ms = SUPERVISOR_WDT_MS;
+    wdt.trigger_panic = true;
+    if (esp_task_wdt_init(&wdt) == ESP_OK) err = esp_task_wdt_add(nullptr);
+  }
+  taskWdtActive = err == ESP_OK;
+
+  StallDetector sensorStall(TASK_STALL_MS);
+  StallDetector loopStall(TASK_STALL_MS);
+  FailureStreak heapLow(HEAP_LOW_CHECKS);
+  uint32_t lastCheckMs = millis();
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(SUPERVISOR_PERIOD_MS));
+    if (taskWdtActive) esp_task_wdt_reset();
+    const uint32_t now = millis();
+
+    if (sensorTaskHandle && sensorStall.update(sensorBeat, now)) controlledRestart(RESTART_SENSOR_STALL);
+    if (loopStall.update(loopBeat, now)) controlledRestart(RESTART_LOOP_STALL);
+
+    const bool heapOk = ESP.getFreeHeap() >= HEAP_RESTART_FREE_BYTES
+                     && heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) >= HEAP_RESTART_BLOCK_BYTES;
+    if (heapLow.report(heapOk)) controlledRestart(RESTART_HEAP);
+
+    portENTER_CRITICAL(&wifiMux);
+    const bool retry = wifiBackoff.take(now);
+    portEXIT_CRITICAL(&wifiMux);
+    if (retry && WiFi.status() != WL_CONNECTED) {
+#ifdef SERIALDEBUG
+      Serial.printf("[WiFi] neuer Versuch, naechster in %lu ms\n", (unsigned long)wifiBackoff.delayMs());
+#endif
+      beginWiFi();
+    }
+
+    if (now - lastCheckMs >= SENSOR_CHECK_MS) {
+      lastCheckMs = now;
+      if (sensorTaskHandle) xTaskNotify(sensorTaskHandle, NOTIFY_CHECK, eSetBits);
+      else initAS3935(); // startet bei Erfolg den Sensor-Task
+    }
+  }
 }
 
 // =============================
 // Setup Sensor
 // =============================
+// Beim Start und aus dem Sensor-Task (checkSensor) nach einem Bus-Fehler
 static bool initAS3935() {
+  AS3935_started = false;
   Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
+  Wire.setClock(AS3935_I2C_HZ);
   delay(50);
   //if (!lightning.begin(AS3935_I2C_ADDR, PIN_AS3935_IRQ)) {
   if (!lightning.begin(Wire)) {
@@ -617,19 +2247,29 @@ static bool initAS3935() {
 
   // Grund-Setup
   lightning.wakeUp();
-  lightning.setIndoorOutdoor(true);       // Indoor-Modus (weniger Rauschen). Outdoor: setIndoor(false)
-  lightning.maskDisturber(false);  // Störer melden? false = nicht maskieren → Bibliothek meldet Disturber separat
-
-  // Empfindlichkeit/Filter (Werte an deine Umgebung anpassen)
-  lightning.setNoiseLevel(2);      // 0..7 (höher = weniger empfindlich ggü. Rauschen)
-  lightning.spikeRejection(2);  // 0..7 (höher = robust, evtl. weniger empfindlich)
-  lightning.watchdogThreshold(2);// 0..10
 
   // Clear event registers
   lightning.clearStatistics(true);
 
+  // Indoor/Outdoor und Empfindlichkeit/Filter aus der Konfiguration (Vorgabe CONFIG_DEFAULT)
+  readAfeRegisters();
+  const DeviceConfig cfg = configSnapshot();
+  applyAfeSettings(cfg.indoor, cfg.afe);
+
+  // Sensor-Task vor dem Interrupt starten, damit der ISR ein Ziel hat
+  if (!sensorTaskHandle) {
+    xTaskCreate(sensorTask, "as3935", SENSOR_TASK_STACK, nullptr, SENSOR_TASK_PRIO, &sensorTaskHandle);
+  }
+
   pinMode(PIN_AS3935_IRQ, INPUT);
+#ifdef LOW_POWER
+  // Pegel statt Flanke: derselbe Interrupt weckt aus dem Light Sleep (siehe onAs3935Interrupt)
+  attachInterrupt(digitalPinToInterrupt(PIN_AS3935_IRQ), onAs3935Interrupt, ONHIGH);
+  gpio_wakeup_enable((gpio_num_t)PIN_AS3935_IRQ, GPIO_INTR_HIGH_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+#else
   attachInterrupt(digitalPinToInterrupt(PIN_AS3935_IRQ), onAs3935Interrupt, RISING);
+#endif
 
 #ifdef SERIALDEBUG    
   Serial.println("AS3935 initialisiert.");
@@ -637,145 +2277,254 @@ static bool initAS3935() {
   return true;
 }
 
-// ESP32 C3 Super Mini on-board LED (works with inverted logic)
-const int ledPin = 8; 
-
-void shortBlink(int num, int onMs = 200, int offMs = 200) {
-  
-    for (int i = 0; i < num; ++i){
-        digitalWrite(ledPin, LOW);
-        delay(onMs);
-        digitalWrite(ledPin, HIGH);
-        delay(offMs);
-    }
-}
-
 // =============================
 // Setup & Loop
 // =============================
+// Zurückgespielte Einträge behalten ihre seq; der erste bestimmt den Neustartpunkt des Speichers
+static void replayToHistory(const LightningEvent& e, uint32_t seq, void*) {
+  if ((int32_t)(seq - history.headSeq()) <= 0) return; // schon vorhanden
+  // Lücken (verworfene Einträge, Neustarts) bleiben Lücken: Nummern werden nie neu vergeben
+  history.skipTo(seq);
+  history.push_back(e);
+  // Ältere Logs enthalten noch Poll-Wiederholungen (irq = false): behalten wegen der
+  // Sequenznummern, aber nicht als Blitz zählen
+  if (!e.irq) return;
+  stats.add(e.ts, e.distance, e.energy);
+  // Der Sensor-Task läuft schon. Ohne gültige Uhr (Kaltstart) startet der Trend leer, sonst
+  // passten die alten Unix-Zeiten nicht zur Zeitbasis des Sensor-Tasks.
+  if (!clockValid) return;
+  portENTER_CRITICAL(&trendMux);
+  trend.update(e.ts, e.distance);
+  portEXIT_CRITICAL(&trendMux);
+}
+
+// Läuft nur bei esp_restart(): letzte Gelegenheit für die Staging-Seiten bei Neustarts ohne
+// flushLogBeforeReboot(). Hält der Schreib-Task den Flash gerade (oder hängt er), wird
+// nicht gewartet – dann geht die Seite verloren wie bei Brownout, Watchdog-Reset oder
+// Stromausfall, bei denen dieser Handler gar nicht läuft (siehe reserveSeqAfterRestart).
+static void flushLogOnShutdown() {
+  eventLog.flush(0);
+}
+
+// Neue Einträge beginnen hinter allen Nummern, die vor dem Neustart vergeben sein können: die
+// Staging-Seiten (bis STAGING_MAX Einträge) gehen bei Brownout, Watchdog-Reset oder Stromausfall
+// ungeschrieben verloren, Clients können sie aber schon gesehen haben. Nach einem Warmstart ist
+// zusätzlich die zuletzt vergebene seq bekannt (deckt auch verworfene Einträge ab).
+static void reserveSeqAfterRestart(bool logValid) {
+  uint32_t next = logValid && eventLog.segmentCount() ? eventLog.nextSeq() + EventLog::STAGING_MAX : 1;
+  if (seqResume.magic == SEQ_RESUME_MAGIC && (int32_t)(seqResume.headSeq + 1 - next) > 0) next = seqResume.headSeq + 1;
+  {
+    HistoryLock lock;
+    history.skipTo(next);
+    seqResume.headSeq = history.headSeq();
+  }
+  seqResume.magic = SEQ_RESUME_MAGIC;
+}
+
+static void restoreHistory() {
+  if (!LittleFS.begin(true) || !eventLog.begin(LittleFS)) {
+#ifdef SERIALDEBUG
+    Serial.println("LittleFS nicht verfuegbar, History nur im RAM");
+#endif
+    reserveSeqAfterRestart(false);
+    return;
+  }
+  size_t n;
+  {
+    HistoryLock lock;
+    n = eventLog.replay(24*3600, replayToHistory, nullptr);
+  }
+  reserveSeqAfterRestart(true);
+  const bool brownout = esp_reset_reason() == ESP_RST_BROWNOUT;
+  eventLog.startWriter(LOG_FLUSH_BATCH, brownout ? LOG_FLUSH_INTERVAL_BROWNOUT_MS : LOG_FLUSH_INTERVAL_MS, LOG_TASK_PRIO);
+  esp_register_shutdown_handler(flushLogOnShutdown);
+#ifdef SERIALDEBUG
+  Serial.printf("History: %u Eintraege aus %lu Segmenten wiederhergestellt\n",
+                (unsigned)n, (unsigned long)eventLog.segmentCount());
+#else
+  (void)n;
+#endif
+}
+
+#ifdef LOW_POWER
+// Dynamische Frequenz + automatischer Light Sleep im Idle-Task. Braucht ein Framework mit
+// CONFIG_PM_ENABLE und CONFIG_FREERTOS_USE_TICKLESS_IDLE; sonst bleibt es bei Modem-Sleep
+// und dem wartenden loop().
+static void setupPowerManagement() {
+  esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "as3935", &sensorPmLock);
+  esp_pm_config_esp32c3_t pm = {};
+  pm.max_freq_mhz = cpuMhz;
+  pm.min_freq_mhz = PM_MIN_FREQ_MHZ;
+  pm.light_sleep_enable = true;
+  const esp_err_t err = esp_pm_configure(&pm);
+#ifdef SERIALDEBUG
+  Serial.printf("Power-Management: %s\n", err == ESP_OK ? "Light Sleep aktiv" : esp_err_to_name(err));
+#else
+  (void)err;
+#endif
+}
+
+// Modem-Sleep nur, solange niemand zuhört: mit Stream-Client oder kurz nach einer Anfrage
+// bleibt der Empfänger an (sonst bis zu einem DTIM-Intervall Verzögerung pro Paket)
+static void updateModemSleep() {
+  static wifi_ps_type_t current = WIFI_PS_MIN_MODEM;
+  const bool busy = streamClientCount() > 0 || millis() - lastRequestMs < HTTP_IDLE_MS;
+  const wifi_ps_type_t want = busy ? WIFI_PS_NONE : WIFI_PS_MIN_MODEM;
+  if (want == current) return;
+  if (esp_wifi_set_ps(want) == ESP_OK) current = want;
+}
+#endif
+
 void setup() {
+  historyMutex = xSemaphoreCreateMutexStatic(&historyMutexBuf);
+  if (restartLog.magic != RESTART_LOG_MAGIC) restartLog = RestartLog{RESTART_LOG_MAGIC, {}};
+  cpuMhz = getCpuFrequencyMhz();
+#ifdef LOW_POWER
+  loopTaskHandle = xTaskGetCurrentTaskHandle(); // setup() und loop() laufen im loopTask
+#endif
 
-  // Blinken zurm Start
-  pinMode(ledPin, OUTPUT);
-  shortBlink(2);
-  
-  tLastPoll = 0;
+  // Nach einem Softreset läuft die RTC-Uhr weiter, dann sind alle Zeitstempel sofort Unix-Zeit
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (isUnixTime(tv.tv_sec)) {
+    eventClock.sync((int64_t)tv.tv_sec * US_PER_SEC + tv.tv_usec, esp_timer_get_time());
+    clockValid = true;
+    pipeline.markSynced();
+  }
 
   Serial.begin(115200);
-  delay(200);
+#ifdef STRIKE_BROADCAST
+  {
+    // getEfuseMac(): Byte 0 der MAC im niederwertigsten Byte
+    const uint64_t efuse = ESP.getEfuseMac();
+    uint8_t mac[6];
+    for (int i = 0; i < 6; ++i) mac[i] = (uint8_t)(efuse >> (8 * i));
+    nodeId = nodeIdFromMac(mac);
+  }
+#endif
 
   pinMode(LED1, OUTPUT);
   pinMode(LED2, OUTPUT);
   pinMode(LED3, OUTPUT);
   pinMode(LED4, OUTPUT);
-  setLedsForDistance(63);
+  showLeds(0);
 
-  delay(1000);
-  bool conwifi=connectWiFi();
-  
-  if (conwifi){
-    shortBlink(5);
-  } else {
-    shortBlink(2,1000,1000);
-  }
+#ifdef LOW_POWER
+  setupPowerManagement(); // vor initAS3935: der Sensor-Task nutzt sensorPmLock
+#endif
 
-  setupTime();
+  loadConfig(); // vor initAS3935: Analogteil und Eventmaske kommen aus dem NVS
 
+  // Sensor zuerst scharf schalten; WLAN, NTP und History laufen danach, ohne auf einander
+  // zu warten (Ereignisse sammeln sich solange in der Sensor-Queue)
   if (!initAS3935()) {
     // weiterlaufen, Webserver hilft beim Debuggen
   }
 
+  connectWiFi(); // kehrt sofort zurück, Rest über onWiFiEvent
+  restoreHistory();
+  startOtaVerify();
+#ifdef MQTT_URI
+  setupMqtt();
+#endif
+
   // Webserver
-  server.on("/", handleRoot);
-  server.on("/api/live", handleLive);
-  server.on("/api/events", handleEvents);
-  server.on("/api/stats", handleStats);
-  server.begin();
+#ifndef USE_ASYNC_WEBSERVER
+  static const char* headerKeys[] = {"If-None-Match"};
+  server.collectHeaders(headerKeys, 1);
+#endif
+  route("/", handleRoot);
+  route("/api/live", handleLive);
+  route("/api/events", handleEvents);
+  route("/api/events.bin", handleEventsBin);
+  route("/api/stats", handleStats);
+  route("/api/series", handleSeries);
+  route("/api/metrics", handleMetrics);
+  route("/api/trend", handleTrend);
+  route("/api/samples", handleSamples);
+  route("/api/interference", handleInterference);
+  route("/api/config", handleConfig);
+#ifdef OTA_PASSWORD
+  setupOta();
+#endif
+#ifdef STRIKE_BROADCAST
+  route("/api/peers", handlePeers);
+#endif
+#ifdef USE_ASYNC_WEBSERVER
+  server.addHandler(&sse);
+#else
+  route("/api/stream", handleStream);
+#endif
+  server.begin(); // lauscht auf allen Interfaces, erreichbar sobald GOT_IP kommt
+
+  // erst jetzt: restoreHistory() darf loop() nicht als hängend erscheinen lassen
+  xTaskCreate(supervisorTask, "supervisor", SUPERVISOR_STACK, nullptr, SUPERVISOR_PRIO, nullptr);
 #ifdef SERIALDEBUG    
   Serial.println("HTTP-Server gestartet auf Port 80");
 #endif  
 }
 
-uint32_t lastEventMs;
+static void drainSensorQueue() {
+  loopBeat = loopBeat + 1;
+  LightningEvent ev;
+  if (clockValid && !pipeline.synced()) flushUnsyncedEvents(); // vor neueren Ereignissen
+  while (sensorQueue.pop(ev)) {
+    handleSensorEvent(ev);
+  }
+}
 
 void loop() {
+#ifdef LOW_POWER
+  // Warten statt drehen: der Idle-Task kann schlafen, neue Messungen wecken sofort.
+  // Vor dem loop()-Timer, damit die Wartezeit nicht im Histogramm landet.
+#ifdef STRIKE_BROADCAST
+  // offenes Datagramm nicht länger als STRIKE_BATCH_MS liegen lassen
+  const uint32_t idleMs = strikeBatch.empty() ? LOOP_IDLE_MS
+                        : std::min(LOOP_IDLE_MS, strikeBatch.remainingMs(millis(), STRIKE_BATCH_MS));
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(idleMs));
+#else
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOOP_IDLE_MS));
+#endif
+  updateModemSleep();
+#endif
+  ScopeTimer loopTimer(mLoop);
+#ifndef USE_ASYNC_WEBSERVER
   server.handleClient();
+  sseMaintain();
+#endif
 
-  // Alte Einträge entfernen (alle Schleifen-Durchläufe leichte Pflege)
+  // Alte Einträge entfernen (alle Schleifen-Durchläufe leichte Pflege); erst mit gültiger Uhr
+  const DeviceConfig cfg = configSnapshot();
   time_t now = time(nullptr);
-  trimHistoryOlderThan(now - 24*3600); // max 24h halten
-
-  AS3935_irq = irqFlag;
-
-  if (irqFlag) {
-    noInterrupts();
-    irqFlag = false;
-    interrupts();
-
-    // Quelle des Interrupts ermitteln
-    delay(5); // Min. 2ms Delay between interrupt goes high and read the register
-    int intSrc = lightning.readInterruptReg();
-    // 0 = keine, 1 = Noise, 4 = Disturber, 8 = Lightning (abhängig von Lib – Doku prüfen)
-
-    lastEvent = intSrc;
-
-    //if (intSrc & 0x08) { // Lightning
-    if (lastEvent & EVENT_MASK) { // Debugging
-      uint8_t dist = lightning.distanceToStorm(); // 1..63 km, 0 = sehr nahe, 63 = out of range
-      uint32_t energy = lightning.lightningEnergy();
-      lastDistance = dist;
-      lastEnergy = energy;
-      lastEventTs = now;
-      lastEventMs = millis();
-      setLedsForDistance(dist);
-
-      // in History aufnehmen
-      if (history.size() >= HISTORY_MAX) history.pop_front();
-      history.push_back({now, dist, energy, lastEvent, AS3935_irq});
-    }
-#ifdef SERIALDEBUG    
-    if (lastEvent & 0x08) { // Debugging
-      Serial.printf("⚡ Blitz erkannt: Distanz %u km, Energy %lu\n", dist, (unsigned long)energy);
-    } else if (intSrc & 0x01) { // Rauschen
-      Serial.println("~ Noise detected");
-    } else if (intSrc & 0x04) { // Störer
-      Serial.println("! Disturber detected");
-    } else {
-      // Unbekannt / kein Event
-    }
-#endif
+  if (clockValid) {
+    // max 24h und config.historyMax halten, abgelaufene Minuten aus den Aggregaten austragen
+    pipeline.trim(now, now - 24*3600, cfg.historyMax);
   }
+#ifdef LED_BLINK_BY_RATE
+  updateLedBlink((uint32_t)trendSnapshot(eventNow()).ratePerMin);
+#endif
 
-  // Optional: alle 10 s Distanz neu abfragen und LEDs aktualisieren
-  if (millis() - tLastPoll > 10000) {
-    
-    if (lastEvent & EVENT_MASK){
-#ifdef SERIALDEBUG      
-      Serial.println("regular data polling (Event)");
-#endif      
-      tLastPoll = millis();
-      uint8_t dist = lightning.distanceToStorm();
-      uint32_t energy = lightning.lightningEnergy();
-      lastDistance = dist;
-      lastEnergy = energy;
-      lastEventTs = now;
-      lastEventMs = millis();
-      setLedsForDistance(dist);
-
-      // in History aufnehmen     
-      if (history.size() >= HISTORY_MAX) history.pop_front();
-      history.push_back({now, dist, energy, lastEvent, AS3935_irq});
-      lastEvent = 0 ;
-    }
+  // Messungen aus dem Sensor-Task übernehmen (Lesen passiert dort, ohne delay() im loop)
+  drainSensorQueue();
+#ifdef STRIKE_BROADCAST
+  if (strikeBatch.due(millis(), STRIKE_BATCH_MS)) flushStrikeBatch();
+#endif
+#ifdef MQTT_URI
+  mqttLoop();
+#endif
+  pushLedsIfChanged();
+  otaVerify();
+#ifdef OTA_PASSWORD
+  if (otaRestartAtMs && (int32_t)(millis() - otaRestartAtMs) >= 0) {
+#ifdef STRIKE_BROADCAST
+    if (!strikeBatch.empty()) flushStrikeBatch();
+#endif
+    flushLogBeforeReboot();
+    esp_restart();
   }
+#endif
 
-  // Resette alles 10min mach dem letzten Event
-  if ((millis() - lastEventMs) > 10*60*1000) {
-    lastDistance = 63;
-    lastEnergy = 0;
-    lastEventMs = millis();
-    lastEventTs = 0;
-    setLedsForDistance(lastDistance);
-  }
+  // Resette alles config.resetSec (Vorgabe 10 min) nach dem letzten Event
+  pipeline.expireLive(millis(), cfg.resetSec * 1000);
 }
 
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+// =============================
+// Host-Mock der SparkFun-AS3935-Bibliothek (env:native)
+// =============================
+// Liefert die Register des nächsten Ereignisses aus einem Trace statt über I2C. Nur die
+// Methoden, die der Lesepfad nutzt; I2C-Zugriffe werden gezählt.
+class SparkFun_AS3935 {
+public:
+  explicit SparkFun_AS3935(uint8_t addr = 0x03) : addr_(addr) {}
+
+  // Nächstes Ereignis „in den Chip legen“ (entspricht dem Zustand beim IRQ)
+  void inject(uint8_t intSrc, uint8_t distance, uint32_t energy) {
+    intSrc_ = intSrc;
+    distance_ = distance;
+    energy_ = energy;
+  }
+
+  uint8_t readInterruptReg() { i2cReads_++; uint8_t v = intSrc_; intSrc_ = 0; return v; }
+  uint8_t distanceToStorm() { i2cReads_++; return distance_; }
+  uint32_t lightningEnergy() { i2cReads_ += 3; return energy_; } // drei Register (0x04..0x06)
+
+  // Burst-Lesen ab Register first (Auto-Increment) wie readAs3935() in main.cpp: eine Transaktion
+  void readRegisters(uint8_t first, uint8_t* buf, uint8_t n) {
+    i2cReads_++;
+    for (uint8_t i = 0; i < n; ++i) {
+      const uint8_t reg = first + i;
+      if (reg == 0x03) { buf[i] = intSrc_; intSrc_ = 0; }
+      else if (reg == 0x04) buf[i] = (uint8_t)energy_;
+      else if (reg == 0x05) buf[i] = (uint8_t)(energy_ >> 8);
+      else if (reg == 0x06) buf[i] = (uint8_t)(energy_ >> 16 & 0x1F);
+      else if (reg == 0x07) buf[i] = distance_;
+      else buf[i] = 0;
+    }
+  }
+
+  uint32_t i2cReads() const { return i2cReads_; } // Transaktionen
+
+private:
+  uint8_t addr_;
+  uint8_t intSrc_ = 0;
+  uint8_t distance_ = 63;
+  uint32_t energy_ = 0;
+  uint32_t i2cReads_ = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// =============================
+// Host-Mock des synchronen WebServer (env:native)
+// =============================
+// Nimmt die Antwort so entgegen wie sendStream() sie im synchronen Modus schreibt
+// (Header, dann sendContent-Chunks) und zählt Bytes/Chunks. Optional wird der Body gesammelt.
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+class WebServer {
+public:
+  bool keepBody = false;
+  std::string body;
+  int code = 0;
+  size_t bytes = 0;
+  size_t chunks = 0;
+
+  void reset() { body.clear(); code = 0; bytes = chunks = 0; }
+
+  void setContentLength(size_t) {}
+  void send(int c, const char*, const char* content) {
+    code = c;
+    sendContent(content, strlenSafe(content));
+  }
+  void sendContent(const char* data, size_t len) {
+    if (len == 0) return;
+    bytes += len;
+    chunks++;
+    if (keepBody) body.append(data, len);
+  }
+  void sendContent(const char* data) { sendContent(data, strlenSafe(data)); }
+
+private:
+  static size_t strlenSafe(const char* s) {
+    size_t n = 0;
+    while (s && s[n]) ++n;
+    return n;
+  }
+};
@@ -0,0 +1,93 @@
+// =============================
+// Host-Test Laufzeit-Konfiguration und AFE-Registerabbild (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "device_config.h"
+
+static constexpr size_t CAPACITY = 8192;
+static constexpr DeviceConfig DEFAULTS = {true, {2, 2, 2, false}, 0b1000, CAPACITY, 600, 10000};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_validate_ranges() {
+  TEST_ASSERT_NULL(validateConfig(DEFAULTS, CAPACITY));
+  DeviceConfig c = DEFAULTS;
+  c.afe.noiseLevel = 8;
+  TEST_ASSERT_EQUAL_STRING("noise_level", validateConfig(c, CAPACITY));
+  c = DEFAULTS;
+  c.historyMax = CAPACITY + 1; // nie über die statische Kapazität
+  TEST_ASSERT_EQUAL_STRING("history_max", validateConfig(c, CAPACITY));
+  c = DEFAULTS;
+  c.eventMask = 0b0010; // kein gültiges Interruptbit
+  TEST_ASSERT_EQUAL_STRING("event_mask", validateConfig(c, CAPACITY));
+  c.eventMask = 0;
+  TEST_ASSERT_EQUAL_STRING("event_mask", validateConfig(c, CAPACITY));
+  c.eventMask = 0b1101;
+  TEST_ASSERT_NULL(validateConfig(c, CAPACITY));
+}
+
+static void test_fields_and_diff() {
+  DeviceConfig c = DEFAULTS;
+  const ConfigField* f = findConfigField("spike_rejection");
+  TEST_ASSERT_NOT_NULL(f);
+  f->set(c, 5);
+  TEST_ASSERT_EQUAL_UINT8(5, c.afe.spike);
+  TEST_ASSERT_NULL(findConfigField("spike"));
+  findConfigField("poll_ms")->set(c, 3000);
+  const uint32_t d = configDiff(DEFAULTS, c);
+  TEST_ASSERT_EQUAL_UINT32(2, __builtin_popcount(d));
+  TEST_ASSERT_TRUE(d & 1u << (f - CONFIG_FIELDS));
+  for (const ConfigField& k : CONFIG_FIELDS) {
+    size_t n = 0;
+    while (k.key[n]) n++;
+    TEST_ASSERT_TRUE(n <= 15); // NVS-Schlüssel
+  }
+}
+
+static void test_register_image_writes_only_changes() {
+  const uint8_t raw[AFE_REG_COUNT] = {0x24, 0x22, 0x62, 0x08}; // INT = Blitz im Abbild verworfen
+  const AfeRegisters cur = afeRegistersFrom(raw);
+  TEST_ASSERT_EQUAL_UINT8(0x00, cur.reg[3]);
+  TEST_ASSERT_EQUAL_UINT8(0, afeRegistersChanged(cur, afeRegisterImage(cur, true, DEFAULTS.afe)));
+
+  // Noise-Level und Watchdog teilen sich 0x01 → ein Schreibzugriff
+  AfeRegisters next = afeRegisterImage(cur, true, {4, 6, 2, false});
+  TEST_ASSERT_EQUAL_UINT8(1u << 1, afeRegistersChanged(cur, next));
+  TEST_ASSERT_EQUAL_UINT8(0x46, next.reg[1]);
+
+  next = afeRegisterImage(cur, false, {2, 2, 2, true});
+  TEST_ASSERT_EQUAL_UINT8(1u << 0 | 1u << 3, afeRegistersChanged(cur, next));
+  TEST_ASSERT_EQUAL_UINT8(0x1C, next.reg[0]);
+  TEST_ASSERT_EQUAL_UINT8(0x20, next.reg[3]);
+  TEST_ASSERT_EQUAL_UINT8(0x62, next.reg[2]); // CL_STAT/MIN_NUM_LIGH bleiben
+}
+
+// Die Registerprüfung vergleicht nur 0x00..0x02; 0x03 (INT, MASK_DIST) wird nicht gelesen
+static void test_register_check_skips_int() {
+  const uint8_t raw[AFE_REG_COUNT] = {0x24, 0x22, 0x62, 0x28};
+  const AfeRegisters img = afeRegistersFrom(raw);
+  TEST_ASSERT_TRUE(afeRegistersMatch(img, raw));
+  const uint8_t reset[AFE_CHECK_COUNT] = {0x24, 0x22, 0xC2}; // 0x02 auf Einschaltwert
+  TEST_ASSERT_FALSE(afeRegistersMatch(img, reset));
+  const uint8_t hung[AFE_CHECK_COUNT] = {0xFF, 0xFF, 0xFF};
+  TEST_ASSERT_FALSE(afeRegistersMatch(img, hung));
+}
+
+static void test_tuner_set_base() {
+  AfeAutoTuner t(DEFAULTS.afe);
+  t.setBase({3, 4, 5, false});
+  TEST_ASSERT_EQUAL_UINT8(3, t.settings().noiseLevel);
+  TEST_ASSERT_TRUE(t.settings() == t.base());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_validate_ranges);
+  RUN_TEST(test_fields_and_diff);
+  RUN_TEST(test_register_image_writes_only_changes);
+  RUN_TEST(test_register_check_skips_int);
+  RUN_TEST(test_tuner_set_base);
+  return UNITY_END();
+}
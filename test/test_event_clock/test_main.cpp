@@ -0,0 +1,104 @@
+// =============================
+// Host-Test Ereigniszeit und Millisekunden im gepackten Format (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "event_clock.h"
+#include "event_store.h"
+#include "event_binary.h"
+
+static constexpr int64_t T0_US = 1750000000LL * US_PER_SEC;
+
+void setUp() {}
+void tearDown() {}
+
+static void test_boot_time_until_sync() {
+  EventClock c;
+  TEST_ASSERT_FALSE(c.synced());
+  TEST_ASSERT_TRUE(c.stamp(1500000) == 1500000);
+  TEST_ASSERT_FALSE(EventClock::isUnix(c.now(1500000)));
+  // NTP: bei mono = 3 s ist es T0
+  c.sync(T0_US, 3 * US_PER_SEC);
+  TEST_ASSERT_TRUE(c.synced());
+  TEST_ASSERT_TRUE(c.now(1500000) == T0_US - 1500000); // zurückgehaltene Ereignisse nachrechnen
+  TEST_ASSERT_TRUE(c.stamp(4 * US_PER_SEC + 250) == T0_US + US_PER_SEC + 250);
+}
+
+static void test_step_back_stays_monotonic() {
+  EventClock c;
+  c.sync(T0_US, 0);
+  const int64_t a = c.stamp(10 * US_PER_SEC);
+  c.sync(T0_US - 2 * US_PER_SEC, 0); // NTP korrigiert die Uhr um 2 s zurück
+  TEST_ASSERT_TRUE(c.lastStepUs() == -2 * US_PER_SEC);
+  TEST_ASSERT_TRUE(c.stamp(11 * US_PER_SEC) == a);               // bleibt stehen …
+  TEST_ASSERT_TRUE(c.stamp(13 * US_PER_SEC) == a + US_PER_SEC); // … bis die Uhr aufgeholt hat
+}
+
+static void test_us_split() {
+  TEST_ASSERT_TRUE(usToSec(T0_US + 999999) == 1750000000);
+  TEST_ASSERT_EQUAL_UINT32(999, usToMs(T0_US + 999999));
+  TEST_ASSERT_TRUE(usToSec(-1) == -1);
+  TEST_ASSERT_EQUAL_UINT32(999, usToMs(-1));
+}
+
+static void test_store_keeps_milliseconds() {
+  static EventStore<16> store;
+  store.clear();
+  for (int i = 0; i < 10; ++i) {
+    LightningEvent e = {1750000000 + i, 10, 100, 8, true, (uint16_t)(i * 111)};
+    store.push_back(e);
+  }
+  for (int i = 0; i < 10; ++i) {
+    TEST_ASSERT_TRUE(store[i].ts == 1750000000 + i);
+    TEST_ASSERT_EQUAL_UINT32(i * 111, store[i].ms);
+    TEST_ASSERT_TRUE(store.tsAt(i) == 1750000000 + i);
+  }
+  TEST_ASSERT_TRUE(store.lowerBoundTs(1750000005) == store.beginPos() + 5);
+}
+
+// Nie leer über mehr als ~49 Tage: die Basis wird auf den ältesten Eintrag nachgezogen
+static void test_store_rebases_after_49_days() {
+  static EventStore<4> store;
+  store.clear();
+  const time_t t = 1750000000;
+  store.push_back({t, 1, 1, 8, true, 5});
+  store.push_back({t + 40 * 24 * 3600, 2, 2, 8, true, 6});
+  store.pop_front();
+  store.push_back({t + 60 * 24 * 3600, 3, 3, 8, true, 7}); // 60 Tage hinter der alten Basis
+  TEST_ASSERT_TRUE(store.base() == t + 40 * 24 * 3600);
+  TEST_ASSERT_EQUAL_UINT32(2, store.size());
+  TEST_ASSERT_TRUE(store[0].ts == t + 40 * 24 * 3600);
+  TEST_ASSERT_EQUAL_UINT32(6, store[0].ms);
+  TEST_ASSERT_TRUE(store[1].ts == t + 60 * 24 * 3600);
+  TEST_ASSERT_EQUAL_UINT32(7, store[1].ms);
+  // zu weit auseinander: der alte Eintrag fällt heraus
+  store.push_back({t + 100 * 24 * 3600, 4, 4, 8, true, 8});
+  TEST_ASSERT_EQUAL_UINT32(2, store.size());
+  TEST_ASSERT_TRUE(store[0].ts == t + 60 * 24 * 3600);
+  TEST_ASSERT_TRUE(store[1].ts == t + 100 * 24 * 3600);
+  TEST_ASSERT_EQUAL_UINT32(8, store[1].ms);
+}
+
+static void test_binary_header_version() {
+  static EventStore<4> store;
+  store.clear();
+  store.push_back({1750000000, 1, 1, 8, true, 250});
+  EventQuery q;
+  EventBinaryStream<EventStore<4>> s(store, q);
+  char buf[64];
+  const size_t n = s.read(buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_UINT32(EVENT_BIN_HEADER_SIZE + 8, n);
+  TEST_ASSERT_EQUAL_UINT8(2, (uint8_t)buf[4]);
+  TEST_ASSERT_EQUAL_UINT8(250, (uint8_t)buf[EVENT_BIN_HEADER_SIZE]); // dt = 250 ms
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_boot_time_until_sync);
+  RUN_TEST(test_step_back_stays_monotonic);
+  RUN_TEST(test_us_split);
+  RUN_TEST(test_store_keeps_milliseconds);
+  RUN_TEST(test_store_rebases_after_49_days);
+  RUN_TEST(test_binary_header_version);
+  return UNITY_END();
+}
@@ -0,0 +1,79 @@
+// =============================
+// Host-Test Störer-Statistik und AFE-Nachführung (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "interference.h"
+
+static constexpr time_t T0 = 1750000020; // Minutengrenze
+static const AfeSettings BASE = {2, 2, 2, false};
+
+static InterferenceStats* stats;
+
+void setUp() { stats = new InterferenceStats(); }
+void tearDown() { delete stats; }
+
+static void test_counts_and_histogram() {
+  for (int i = 0; i < 30; ++i) stats->add(T0 + i * 10, INT_DISTURBER); // 5 min lang 6/min
+  stats->add(T0, INT_NOISE);
+  stats->add(T0, INT_LIGHTNING); // kein Störer → ignoriert
+  TEST_ASSERT_EQUAL_UINT32(30, stats->totals().disturber);
+  TEST_ASSERT_EQUAL_UINT32(1, stats->totals().noise);
+  const time_t now = T0 + 290;
+  TEST_ASSERT_EQUAL_UINT32(30, stats->window(now, 60).disturber);
+  TEST_ASSERT_EQUAL_UINT32(6, stats->minuteAgo(now, 0).disturber);
+  TEST_ASSERT_EQUAL_UINT32(6, stats->minuteAgo(now, 4).disturber);
+  TEST_ASSERT_EQUAL_UINT32(0, stats->minuteAgo(now, 5).disturber);
+  // nach einer Stunde ist alles aus dem Histogramm gefallen, die Gesamtzähler bleiben
+  TEST_ASSERT_EQUAL_UINT32(0, stats->window(now + 3600, 60).disturber);
+  TEST_ASSERT_EQUAL_UINT32(30, stats->totals().disturber);
+}
+
+// Wechselrichter in der Nähe: 30 Störer/min über längere Zeit
+static void test_tuner_backs_off_under_disturbers() {
+  AfeAutoTuner tuner(BASE);
+  time_t t = T0;
+  uint32_t changes = 0;
+  for (int sec = 0; sec < 3 * 3600; ++sec, ++t) {
+    if (sec % 2 == 0) stats->add(t, INT_DISTURBER);
+    if (tuner.evaluate(t, *stats)) changes++;
+  }
+  const AfeSettings& s = tuner.settings();
+  TEST_ASSERT_TRUE(changes >= 3);
+  TEST_ASSERT_TRUE(s.watchdog > BASE.watchdog);
+  TEST_ASSERT_TRUE(s.spike > BASE.spike);
+  TEST_ASSERT_EQUAL_UINT8(BASE.noiseLevel, s.noiseLevel);
+  // höchstens ein Schritt pro Sperrzeit
+  TEST_ASSERT_TRUE(changes <= 3 * 3600 / AfeAutoTuner::COOLDOWN_SEC + 1);
+}
+
+static void test_tuner_raises_noise_floor() {
+  AfeAutoTuner tuner(BASE);
+  time_t t = T0;
+  for (int sec = 0; sec < 600; ++sec, ++t) {
+    if (sec % 10 == 0) stats->add(t, INT_NOISE); // 6/min
+    tuner.evaluate(t, *stats);
+  }
+  TEST_ASSERT_TRUE(tuner.settings().noiseLevel > BASE.noiseLevel);
+}
+
+static void test_tuner_relaxes_after_quiet() {
+  AfeAutoTuner tuner(BASE);
+  time_t t = T0;
+  for (int sec = 0; sec < 1800; ++sec, ++t) {
+    stats->add(t, INT_DISTURBER);
+    tuner.evaluate(t, *stats);
+  }
+  TEST_ASSERT_FALSE(tuner.settings() == BASE);
+  for (int sec = 0; sec < 12 * 3600; ++sec, ++t) tuner.evaluate(t, *stats);
+  TEST_ASSERT_TRUE(tuner.settings() == BASE);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_counts_and_histogram);
+  RUN_TEST(test_tuner_backs_off_under_disturbers);
+  RUN_TEST(test_tuner_raises_noise_floor);
+  RUN_TEST(test_tuner_relaxes_after_quiet);
+  return UNITY_END();
+}
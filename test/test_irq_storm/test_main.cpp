@@ -0,0 +1,95 @@
+// =============================
+// Host-Test IRQ-Sturmschutz (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "irq_storm.h"
+
+static constexpr uint32_t MAX_PER_SEC = 20;
+static constexpr uint32_t HOLD_MS = 60000;
+
+void setUp() {}
+void tearDown() {}
+
+// Simuliert den Sensor-Task: Flanken kommen im Abstand periodMs, gelesen wird erst nach der
+// Drosselzeit; alle dazwischen liegenden Flanken werden zu einem Lesevorgang zusammengefasst
+static uint32_t run(IrqStormGuard& g, uint32_t& now, uint32_t durationMs, uint32_t periodMs,
+                    uint32_t& lastRead, uint32_t* changes = nullptr) {
+  const uint32_t end = now + durationMs;
+  uint32_t pending = 0, nextEdge = now;
+  for (; now < end; ++now) {
+    if (periodMs && now >= nextEdge) { pending++; nextEdge += periodMs; }
+    if (pending && now - lastRead >= 2 && g.readDelayMs(now, lastRead) == 0) {
+      g.onRead(now, pending);
+      pending = 0;
+      lastRead = now;
+    }
+    if (now % 1000 == 0 && g.update(now) && changes) (*changes)++;
+  }
+  return pending;
+}
+
+static void test_normal_rate_stays_quiet() {
+  IrqStormGuard g(MAX_PER_SEC, HOLD_MS);
+  uint32_t now = 1000, lastRead = 0;
+  run(g, now, 30000, 200, lastRead); // 5/s
+  TEST_ASSERT_FALSE(g.active());
+  TEST_ASSERT_EQUAL_UINT32(0, g.storms());
+  TEST_ASSERT_EQUAL_UINT32(0, g.coalesced());
+  TEST_ASSERT_EQUAL_UINT32(g.edges(), g.reads());
+}
+
+static void test_storm_throttles_and_coalesces() {
+  IrqStormGuard g(MAX_PER_SEC, HOLD_MS);
+  uint32_t now = 1000, lastRead = 0, changes = 0;
+  run(g, now, 10000, 5, lastRead, &changes); // 200/s
+  TEST_ASSERT_TRUE(g.active());
+  TEST_ASSERT_EQUAL_UINT32(1, g.storms());
+  TEST_ASSERT_EQUAL_UINT32(1, changes);
+  // höchstens 10 Lesevorgänge/s im Sturm, der Rest zusammengefasst
+  TEST_ASSERT_TRUE(g.reads() < 10 * 10 + MAX_PER_SEC + 2);
+  TEST_ASSERT_TRUE(g.coalesced() > 1500);
+  TEST_ASSERT_EQUAL_UINT32(g.edges(), g.reads() + g.coalesced());
+}
+
+static void test_storm_ends_after_hold_and_backs_off() {
+  IrqStormGuard g(MAX_PER_SEC, HOLD_MS);
+  uint32_t now = 1000, lastRead = 0, changes = 0;
+  run(g, now, 5000, 5, lastRead, &changes);
+  TEST_ASSERT_TRUE(g.active());
+  // Pin ständig wieder high: trotz Drosselung kein Ende
+  run(g, now, 2 * HOLD_MS, 5, lastRead, &changes);
+  TEST_ASSERT_TRUE(g.active());
+  // ruhig: nach HOLD_MS (+ Fensterabschluss) vorbei
+  run(g, now, HOLD_MS + 3000, 0, lastRead, &changes);
+  TEST_ASSERT_FALSE(g.active());
+  TEST_ASSERT_EQUAL_UINT32(2, changes);
+  // sofort der nächste Sturm → doppelte Haltezeit
+  run(g, now, 5000, 5, lastRead, &changes);
+  TEST_ASSERT_TRUE(g.active());
+  TEST_ASSERT_EQUAL_UINT32(2, g.storms());
+  TEST_ASSERT_EQUAL_UINT32(2 * HOLD_MS, g.holdMs());
+  run(g, now, HOLD_MS + 3000, 0, lastRead);
+  TEST_ASSERT_TRUE(g.active());
+  run(g, now, HOLD_MS, 0, lastRead);
+  TEST_ASSERT_FALSE(g.active());
+}
+
+static void test_millis_wraparound() {
+  IrqStormGuard g(MAX_PER_SEC, HOLD_MS);
+  uint32_t now = UINT32_MAX - 3000, lastRead = now - 10;
+  g.update(now);
+  for (int i = 0; i < 30; ++i) g.onRead(now += 10, 1);
+  TEST_ASSERT_TRUE(g.active());
+  TEST_ASSERT_EQUAL_UINT32(100, g.readDelayMs(lastRead = now, now));
+  TEST_ASSERT_EQUAL_UINT32(40, g.readDelayMs(now + 60, lastRead));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_normal_rate_stays_quiet);
+  RUN_TEST(test_storm_throttles_and_coalesces);
+  RUN_TEST(test_storm_ends_after_hold_and_backs_off);
+  RUN_TEST(test_millis_wraparound);
+  return UNITY_END();
+}
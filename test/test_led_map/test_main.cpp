@@ -0,0 +1,49 @@
+// =============================
+// Host-Test der LED-Tabelle (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "led_map.h"
+
+// Die Tabelle entsteht zur Compile-Zeit
+static_assert(LED_LUT[63] == 0, "out of range = aus");
+static_assert(LED_LUT[1] == 0b1111, "ueber Kopf = alle");
+static_assert(LED_LUT[40] == 0b0001, "40 km = LED1");
+
+void setUp() {}
+void tearDown() {}
+
+// Jede gelistete Stufe liefert genau ihr Muster (wie der frühere switch)
+static void test_listed_codes() {
+  for (const LedMapEntry& e : LED_DISTANCE_TABLE) {
+    TEST_ASSERT_EQUAL_UINT8(e.mask, LED_LUT[e.km]);
+  }
+}
+
+// Nicht gelistete Codes → nächstgelegene Stufe, bei Gleichstand die nähere Entfernung
+static void test_nearest_bucket() {
+  TEST_ASSERT_EQUAL_UINT8(LED_LUT[1], LED_LUT[0]);    // 0 = sehr nahe
+  TEST_ASSERT_EQUAL_UINT8(LED_LUT[1], LED_LUT[3]);    // 1 und 5 gleich weit → 1
+  TEST_ASSERT_EQUAL_UINT8(LED_LUT[5], LED_LUT[4]);
+  TEST_ASSERT_EQUAL_UINT8(LED_LUT[17], LED_LUT[18]);
+  TEST_ASSERT_EQUAL_UINT8(LED_LUT[20], LED_LUT[19]);
+  TEST_ASSERT_EQUAL_UINT8(LED_LUT[40], LED_LUT[50]);
+  TEST_ASSERT_EQUAL_UINT8(LED_LUT[40], LED_LUT[62]);  // nur 63 schaltet aus
+  TEST_ASSERT_EQUAL_UINT8(LED_LUT[63], LED_LUT[63 + 64]); // Index wird maskiert
+}
+
+static void test_gpio_bits() {
+  constexpr LedGpioLut g = makeLedGpioLut(3, 4, 5, 1);
+  TEST_ASSERT_EQUAL_UINT32(0, g[0]);
+  TEST_ASSERT_EQUAL_UINT32(1u << 3, g[0b0001]);
+  TEST_ASSERT_EQUAL_UINT32((1u << 4) | (1u << 1), g[0b1010]);
+  TEST_ASSERT_EQUAL_UINT32((1u << 1) | (1u << 3) | (1u << 4) | (1u << 5), g.all);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_listed_codes);
+  RUN_TEST(test_nearest_bucket);
+  RUN_TEST(test_gpio_bits);
+  return UNITY_END();
+}
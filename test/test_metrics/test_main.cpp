@@ -0,0 +1,88 @@
+// =============================
+// Host-Test der Metrik-Ausgabe (pio test -e native)
+// =============================
+// /api/metrics entsteht abschnittsweise in einem festen Puffer (MetricsStream); geprüft wird,
+// dass die Chunks zusammen die Seite ergeben und der größte Abschnitt in den Puffer passt.
+#include <unity.h>
+
+#include <string>
+
+#include "metrics.h"
+
+static constexpr size_t CHUNK = 2048; // wie METRICS_CHUNK_MAX in main.cpp
+
+static LatencyHistogram hist;
+
+void setUp() {}
+void tearDown() {}
+
+static bool renderPage(MetricsBuffer<CHUNK>& out, size_t step) {
+  switch (step) {
+    case 0:
+      appendMetricHeader(out, "test_us", "histogram", "Histogramm");
+      appendHistogram(out, "test_us", "op=\"a\"", hist);
+      break;
+    case 1:
+      break; // leerer Abschnitt (z. B. Feature nicht gebaut)
+    case 2:
+      appendMetricHeader(out, "test_total", "counter", "Zähler");
+      appendMetricValue(out, "test_total", nullptr, 42);
+      break;
+    default:
+      return false;
+  }
+  return true;
+}
+
+// Zeilen gehen ganz oder gar nicht in den Puffer
+static void test_buffer_keeps_whole_lines() {
+  MetricsBuffer<16> b;
+  b += "abc\n";
+  b += "0123456789abc\n"; // passt nicht mehr
+  TEST_ASSERT_EQUAL_UINT32(4, b.size());
+  TEST_ASSERT_TRUE(b.overflowed());
+  b += "de\n";
+  TEST_ASSERT_EQUAL_STRING_LEN("abc\nde\n", b.data(), 7);
+}
+
+// Kleine read()-Häppchen ergeben dieselbe Seite wie ein String am Stück
+static void test_stream_matches_string() {
+  for (uint32_t us : {10u, 80u, 300u, 4000u, 2000000u}) hist.observe(us);
+  std::string whole;
+  appendMetricHeader(whole, "test_us", "histogram", "Histogramm");
+  appendHistogram(whole, "test_us", "op=\"a\"", hist);
+  appendMetricHeader(whole, "test_total", "counter", "Zähler");
+  appendMetricValue(whole, "test_total", nullptr, 42);
+
+  MetricsStream<CHUNK> s(renderPage);
+  std::string got;
+  char buf[7];
+  size_t n;
+  while ((n = s.read(buf, sizeof(buf))) > 0) got.append(buf, n);
+  TEST_ASSERT_EQUAL_STRING(whole.c_str(), got.c_str());
+  TEST_ASSERT_FALSE(s.overflowed());
+  TEST_ASSERT_EQUAL_UINT32(0, s.read(buf, sizeof(buf))); // bleibt am Ende
+}
+
+// Größter Abschnitt in main.cpp: Routen-Histogramm mit Kopf, längster Pfad, Zähler mit 10 und
+// Summe mit 20 Stellen
+static void test_largest_section_fits() {
+  MetricsBuffer<CHUNK> out;
+  LatencyHistogram h;
+  h.observe(1);
+  appendMetricHeader(out, "lightning_http_handler_us", "histogram", "Laufzeit der HTTP-Handler");
+  appendHistogram(out, "lightning_http_handler_us", "path=\"/api/events.bin/xxxxxxx\"", h);
+  const size_t worst = out.size() + (LatencyHistogram::BUCKETS + 2) * 9 + 19;
+  printf("[metrics] Routen-Abschnitt %lu B, Worst Case %lu B von %lu\n",
+         (unsigned long)out.size(), (unsigned long)worst, (unsigned long)CHUNK);
+  TEST_ASSERT_FALSE(out.overflowed());
+  TEST_ASSERT_TRUE(worst <= CHUNK);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_buffer_keeps_whole_lines);
+  RUN_TEST(test_stream_matches_string);
+  RUN_TEST(test_largest_section_fits);
+  return UNITY_END();
+}
@@ -0,0 +1,80 @@
+// =============================
+// Host-Test MQTT-Cursor und Ratenbegrenzung (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "mqtt_outbox.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Sendet, solange der Cursor etwas liefert; msgId = seq + 1000
+static uint32_t pump(PublishCursor& c, uint32_t oldest, uint32_t head) {
+  uint32_t seq = 0, n = 0;
+  while (c.next(oldest, head, seq)) {
+    c.sent((int)seq + 1000, seq);
+    n++;
+  }
+  return n;
+}
+
+static void test_window_and_acks() {
+  PublishCursor c;
+  c.start(10);
+  TEST_ASSERT_EQUAL_UINT32(0, pump(c, 1, 10)); // nichts Neues
+  TEST_ASSERT_EQUAL_UINT32(PublishCursor::MAX_INFLIGHT, pump(c, 1, 30));
+  // PUBACKs außer der Reihe: acked zieht nur über lückenlos bestätigte nach
+  c.acked(1012);
+  TEST_ASSERT_EQUAL_UINT32(10, c.ackedSeq());
+  c.acked(1011);
+  TEST_ASSERT_EQUAL_UINT32(12, c.ackedSeq());
+  TEST_ASSERT_EQUAL_UINT32(PublishCursor::MAX_INFLIGHT - 2, c.inflight());
+  TEST_ASSERT_EQUAL_UINT32(2, pump(c, 1, 30));
+  TEST_ASSERT_EQUAL_UINT32(18, c.pending(30));
+  c.acked(4711); // unbekannt → ignoriert
+  TEST_ASSERT_EQUAL_UINT32(12, c.ackedSeq());
+}
+
+static void test_failed_resends_without_gaps() {
+  PublishCursor c;
+  c.start(0);
+  pump(c, 1, 5);
+  c.acked(1001);
+  c.failed(1003); // 3 abgelaufen → 3..5 noch einmal
+  TEST_ASSERT_EQUAL_UINT32(1, c.inflight());
+  uint32_t seq;
+  TEST_ASSERT_TRUE(c.next(1, 5, seq));
+  TEST_ASSERT_EQUAL_UINT32(3, seq);
+  TEST_ASSERT_EQUAL_UINT32(1, c.retries());
+}
+
+static void test_trimmed_history_counts_lost() {
+  PublishCursor c;
+  c.start(100);
+  uint32_t seq;
+  TEST_ASSERT_TRUE(c.next(150, 160, seq)); // 101..149 aus der History gefallen
+  TEST_ASSERT_EQUAL_UINT32(150, seq);
+  TEST_ASSERT_EQUAL_UINT32(49, c.lost());
+  TEST_ASSERT_EQUAL_UINT32(149, c.ackedSeq());
+  c.skip(150);
+  TEST_ASSERT_EQUAL_UINT32(150, c.ackedSeq());
+}
+
+static void test_rate_limiter() {
+  RateLimiter r(5, 10);
+  uint32_t ok = 0;
+  for (uint32_t t = 0; t < 2000; t += 10) ok += r.take(1000 + t);
+  TEST_ASSERT_EQUAL_UINT32(10 + 2 * 5 - 1, ok); // Burst + 2 s × 5/s (letzter Token erst bei 3000)
+  TEST_ASSERT_TRUE(r.take(3000));
+  TEST_ASSERT_FALSE(r.take(3100));
+  TEST_ASSERT_TRUE(r.take(3000 + 120000)); // nach langer Pause wieder voll
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_window_and_acks);
+  RUN_TEST(test_failed_resends_without_gaps);
+  RUN_TEST(test_trimmed_history_counts_lost);
+  RUN_TEST(test_rate_limiter);
+  return UNITY_END();
+}
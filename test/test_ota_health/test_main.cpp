@@ -0,0 +1,50 @@
+// =============================
+// Host-Test Gesundheitsprüfung nach OTA (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "ota_health.h"
+
+using Verdict = OtaHealthCheck::Verdict;
+
+void setUp() {}
+void tearDown() {}
+
+static void test_valid_after_hold() {
+  OtaHealthCheck h(30000, 180000);
+  TEST_ASSERT_TRUE(h.update(0, true) == Verdict::Wait); // nicht gestartet
+  h.start(1000);
+  TEST_ASSERT_TRUE(h.pending());
+  TEST_ASSERT_TRUE(h.update(5000, false) == Verdict::Wait);
+  TEST_ASSERT_TRUE(h.update(10000, true) == Verdict::Wait);
+  TEST_ASSERT_TRUE(h.update(39999, true) == Verdict::Wait);
+  TEST_ASSERT_TRUE(h.update(40000, true) == Verdict::Valid);
+  TEST_ASSERT_FALSE(h.pending());
+  TEST_ASSERT_TRUE(h.update(50000, false) == Verdict::Wait);
+}
+
+// Kurz gesund, dann wieder nicht: die Haltezeit beginnt von vorn
+static void test_flapping_rolls_back() {
+  OtaHealthCheck h(30000, 180000);
+  h.start(0);
+  for (uint32_t t = 0; t < 180000; t += 1000) {
+    TEST_ASSERT_TRUE(h.update(t, (t / 1000) % 20 < 15) == Verdict::Wait);
+  }
+  TEST_ASSERT_TRUE(h.update(180000, true) == Verdict::Rollback);
+  TEST_ASSERT_FALSE(h.pending());
+}
+
+static void test_millis_wrap() {
+  OtaHealthCheck h(1000, 5000);
+  h.start(UINT32_MAX - 500);
+  TEST_ASSERT_TRUE(h.update(UINT32_MAX - 400, true) == Verdict::Wait);
+  TEST_ASSERT_TRUE(h.update(700, true) == Verdict::Valid);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_valid_after_hold);
+  RUN_TEST(test_flapping_rolls_back);
+  RUN_TEST(test_millis_wrap);
+  return UNITY_END();
+}
@@ -0,0 +1,612 @@
+// =============================
+// Host-Test & Benchmark der Ereignis-Pipeline (pio test -e native)
+// =============================
+// Spielt einen Gewitter-Trace durch denselben Weg wie auf dem Gerät:
+//   Mock-AS3935 → Lesen wie im Sensor-Task → SpscQueue → EventPipeline (event_pipeline.h, wie
+//   loop() in main.cpp) → History + Minuten-Aggregate
+// und serialisiert die volle History über den Mock-WebServer (JSON und Binär, mit
+// sendStreamChunked() wie der synchrone Zweig von sendStream()). Ausgabe: Ereignisse/s, Verzögerung bei 10/100/1000-facher Geschwindigkeit,
+// µs pro serialisiertem Ereignis und Speicherbedarf.
+//
+// Trace: test/traces/storm_sample.csv oder Pfad in LIGHTNING_TRACE. Wall-Budget pro
+// Geschwindigkeit: LIGHTNING_BENCH_MS (Default 1000); der Trace läuft dafür in Schleife weiter.
+
+#include <unity.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <SparkFun_AS3935.h>
+#include <WebServer.h>
+
+#include "event_store.h"
+#include "event_json.h"
+#include "event_binary.h"
+#include "stats_aggregate.h"
+#include "spsc_queue.h"
+#include "as3935_burst.h"
+#include "event_pipeline.h"
+
+// =============================
+// Heap-Zählung (Spitzenwert während eines Laufs)
+// =============================
+static size_t heapNow = 0;
+static size_t heapPeak = 0;
+
+void* operator new(size_t n) {
+  size_t* p = static_cast<size_t*>(std::malloc(n + sizeof(size_t)));
+  if (!p) throw std::bad_alloc();
+  *p = n;
+  heapNow += n;
+  if (heapNow > heapPeak) heapPeak = heapNow;
+  return p + 1;
+}
+void operator delete(void* q) noexcept {
+  if (!q) return;
+  size_t* p = static_cast<size_t*>(q) - 1;
+  heapNow -= *p;
+  std::free(p);
+}
+void operator delete(void* q, size_t) noexcept { operator delete(q); }
+
+// =============================
+// Trace
+// =============================
+struct TraceEntry {
+  uint32_t tMs;
+  uint8_t intSrc;
+  uint8_t distance;
+  uint32_t energy;
+};
+
+static std::vector<TraceEntry> trace;
+static uint32_t traceSpanMs = 0;
+
+// Trace so drehen, dass er mit der dichtesten Minute beginnt (kurze Läufe messen sonst nur
+// den ruhigen Anfang) und bei t = 0 startet
+static void rotateToPeak() {
+  size_t best = 0, bestN = 0, j = 0;
+  for (size_t i = 0; i < trace.size(); ++i) {
+    while (j < trace.size() && trace[j].tMs < trace[i].tMs + 60000) ++j;
+    if (j - i > bestN) { bestN = j - i; best = i; }
+  }
+  const uint32_t span = trace.back().tMs - trace.front().tMs + 1000;
+  const uint32_t t0 = trace[best].tMs;
+  std::vector<TraceEntry> r;
+  for (size_t k = 0; k < trace.size(); ++k) {
+    TraceEntry e = trace[(best + k) % trace.size()];
+    e.tMs = e.tMs >= t0 ? e.tMs - t0 : e.tMs - trace.front().tMs + (span - (t0 - trace.front().tMs));
+    r.push_back(e);
+  }
+  trace.swap(r);
+}
+
+static bool loadTrace(const char* path) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[128];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] == '#' || line[0] == '\n') continue;
+    unsigned long t, s, d, e;
+    if (sscanf(line, "%lu,%lu,%lu,%lu", &t, &s, &d, &e) == 4) {
+      trace.push_back({(uint32_t)t, (uint8_t)s, (uint8_t)d, (uint32_t)e});
+    }
+  }
+  fclose(f);
+  return !trace.empty();
+}
+
+// Ersatz, falls die Datei nicht gefunden wird: gleichmäßiger Sturm, 20 Blitze/min
+static void synthTrace() {
+  static const uint8_t steps[] = {1, 5, 6, 8, 10, 12, 14, 17, 20, 24, 27, 31, 34, 37, 40, 63};
+  for (uint32_t i = 0; i < 1800; ++i) {
+    trace.push_back({i * 3000, (uint8_t)(i % 10 == 0 ? 4 : 8), steps[i % 16], i * 97});
+  }
+}
+
+// =============================
+// Pipeline wie in main.cpp
+// =============================
+static constexpr uint8_t EVENT_MASK = 0b1000;
+static constexpr size_t HISTORY_MAX = 8192;
+static constexpr time_t T0 = 1750000000;
+
+// Ein Thread: keine Sperren. restamp() verschiebt Boot-Sekunden um bootOffset (statt Uhr + monoUs).
+struct NoLock {
+  NoLock() {} // nicht trivial: keine Warnung für die ungenutzte Sperre
+};
+
+struct TestHooks {
+  using Lock = NoLock;
+  using LiveLock = NoLock;
+  uint32_t records = 0;
+  uint32_t lastSeq = 0;
+  time_t bootOffset = 0;
+  void recorded(const LightningEvent&, uint32_t seq) { records++; lastSeq = seq; }
+  void restamp(LightningEvent& e) { e.ts += bootOffset; }
+};
+
+struct Pipeline {
+  SparkFun_AS3935 sensor;
+  SpscQueue<LightningEvent, 64> queue;
+  EventStore<HISTORY_MAX> history;
+  MinuteAggregates stats;
+  RingBuffer<DistanceSample, 32> samples;
+  TestHooks hooks;
+  EventPipeline<HISTORY_MAX, 32, TestHooks> events{history, stats, samples, hooks};
+  uint32_t drops = 0;
+
+  Pipeline() { events.markSynced(); }
+
+  // Sensor-Task nach dem IRQ: 0x03..0x07 in einem Burst
+  void onIrq(time_t now) {
+    uint8_t buf[AS3935_BURST_LEN] = {};
+    sensor.readRegisters(AS3935_REG_INT, buf, AS3935_BURST_LEN);
+    const As3935Reading r = decodeAs3935Burst(buf);
+    LightningEvent ev = {now, 63, 0, r.intSrc, true};
+    if (r.intSrc & EVENT_MASK) {
+      ev.distance = r.distance;
+      ev.energy = r.energy;
+    }
+    if (!queue.push(ev)) drops++;
+  }
+
+  // loop(): trimmen, Aggregate nachziehen, Queue leeren, handleSensorEvent()
+  void loop(time_t now) {
+    events.trim(now, now - 24 * 3600, HISTORY_MAX);
+    LightningEvent ev;
+    while (queue.pop(ev)) events.handle(ev, EVENT_MASK, (uint32_t)((now - T0) * 1000));
+  }
+};
+
+static Pipeline* pipe = nullptr;
+
+// Synchroner Zweig von sendStream()
+template <typename S>
+static void pump(WebServer& srv, S& stream) {
+  sendStreamChunked<NoLock>(srv, "application/json", stream);
+}
+
+static uint32_t benchMs() {
+  const char* s = getenv("LIGHTNING_BENCH_MS");
+  return s ? (uint32_t)strtoul(s, nullptr, 10) : 1000;
+}
+
+using Clock = std::chrono::steady_clock;
+static double usSince(Clock::time_point t) {
+  return std::chrono::duration<double, std::micro>(Clock::now() - t).count();
+}
+
+// =============================
+// Tests
+// =============================
+void setUp() {
+  pipe = new Pipeline();
+}
+
+void tearDown() {
+  delete pipe;
+  pipe = nullptr;
+}
+
+// Ungedrosselt: wie viele Ereignisse pro Sekunde schafft der Pfad Lesen → Speichern?
+static void test_replay_throughput() {
+  const size_t rounds = 1 + 200000 / trace.size();
+  const Clock::time_point t = Clock::now();
+  uint64_t n = 0;
+  for (size_t r = 0; r < rounds; ++r) {
+    const uint64_t offMs = (uint64_t)r * (traceSpanMs + 1000);
+    for (const TraceEntry& e : trace) {
+      const time_t now = T0 + (time_t)((offMs + e.tMs) / 1000);
+      pipe->sensor.inject(e.intSrc, e.distance, e.energy);
+      pipe->onIrq(now);
+      pipe->loop(now);
+      ++n;
+    }
+  }
+  const double us = usSince(t);
+  printf("[replay] %llu IRQs in %.1f ms → %.0f Ereignisse/s (%.3f µs/Ereignis), I2C-Reads %lu\n",
+         (unsigned long long)n, us / 1000, n * 1e6 / us, us / n, (unsigned long)pipe->sensor.i2cReads());
+  TEST_ASSERT_EQUAL_UINT32(0, pipe->drops);
+  TEST_ASSERT_TRUE(pipe->history.size() <= HISTORY_MAX);
+}
+
+// Trace in 10/100/1000-facher Echtzeit: hält die Pipeline mit, wie groß ist die Verzögerung?
+static void runAtSpeed(uint32_t speed) {
+  const uint32_t budgetMs = benchMs();
+  const Clock::time_point start = Clock::now();
+  double maxLagUs = 0, sumLagUs = 0;
+  uint64_t n = 0;
+  for (uint64_t round = 0;; ++round) {
+    const uint64_t offMs = round * (traceSpanMs + 1000);
+    bool done = false;
+    for (const TraceEntry& e : trace) {
+      const double dueUs = (offMs + e.tMs) * 1000.0 / speed;
+      if (dueUs / 1000 > budgetMs) { done = true; break; }
+      const Clock::time_point due = start + std::chrono::microseconds((int64_t)dueUs);
+      std::this_thread::sleep_until(due);
+      const time_t now = T0 + (time_t)((offMs + e.tMs) / 1000);
+      pipe->sensor.inject(e.intSrc, e.distance, e.energy);
+      pipe->onIrq(now);
+      pipe->loop(now);
+      const double lag = usSince(due);
+      if (lag > maxLagUs) maxLagUs = lag;
+      sumLagUs += lag;
+      ++n;
+    }
+    if (done) break;
+  }
+  const double wallS = usSince(start) / 1e6;
+  printf("[replay %4lux] %llu Ereignisse in %.2f s → %.0f/s, Verzögerung Ø %.1f µs, max %.1f µs\n",
+         (unsigned long)speed, (unsigned long long)n, wallS, n / wallS, n ? sumLagUs / n : 0.0, maxLagUs);
+  TEST_ASSERT_EQUAL_UINT32(0, pipe->drops);
+}
+
+static void test_replay_10x() { runAtSpeed(10); }
+static void test_replay_100x() { runAtSpeed(100); }
+static void test_replay_1000x() { runAtSpeed(1000); }
+
+// Aggregate müssen mit einer Zählung über die History übereinstimmen
+static void test_stats_match_history() {
+  time_t now = T0;
+  for (const TraceEntry& e : trace) {
+    now = T0 + e.tMs / 1000;
+    pipe->sensor.inject(e.intSrc, e.distance, e.energy);
+    pipe->onIrq(now);
+    pipe->loop(now);
+  }
+  const long ranges[] = {5 * 60, 15 * 60, 3600, 24 * 3600};
+  for (long r : ranges) {
+    // Auflösung 1 Minute: gezählt wird ab Beginn der Minute, in der das Fenster beginnt
+    const time_t cutoff = ((now / 60) - MinuteAggregates::minutesFor(r) + 1) * 60;
+    uint32_t n = 0;
+    for (size_t i = 0; i < pipe->history.size(); ++i) n += pipe->history.tsAt(i) >= cutoff;
+    TEST_ASSERT_EQUAL_UINT32(n, pipe->stats.query(r).count());
+  }
+}
+
+// Vorgebinnte Reihen (/api/series) aus denselben Minuten-Slots
+static void test_series_bins() {
+  static MinuteAggregates agg;
+  agg.clear();
+  const time_t m0 = (T0 / 60) * 60;
+  agg.add(m0 + 5, 12, 100);
+  agg.add(m0 + 50, 8, 5000);
+  agg.add(m0 + 70, 63, 70000);  // out of range: zählt, aber ohne Distanz
+  agg.add(m0 + 130, 20, 300);
+  agg.advance(m0 + 150);        // laufende Minute = m0 + 2 min
+
+  SeriesBin bins[3];
+  agg.series(1, 3, bins);
+  TEST_ASSERT_EQUAL_UINT32(1, bins[0].count);
+  TEST_ASSERT_EQUAL_UINT8(20, bins[0].minKm);
+  TEST_ASSERT_EQUAL_UINT32(1, bins[1].count);
+  TEST_ASSERT_EQUAL_UINT32(0, bins[1].nKm);
+  TEST_ASSERT_TRUE(bins[1].avgKm() < 0);
+  TEST_ASSERT_EQUAL_UINT32(70000, bins[1].maxEnergy);
+  TEST_ASSERT_EQUAL_UINT32(2, bins[2].count);
+  TEST_ASSERT_EQUAL_UINT8(8, bins[2].minKm);
+  TEST_ASSERT_TRUE(bins[2].avgKm() == 10.0f);
+  TEST_ASSERT_EQUAL_UINT32(5000, bins[2].maxEnergy);
+
+  // 2-Minuten-Bins: [m0+1, m0+2], [m0-1, m0]
+  agg.series(2, 2, bins);
+  TEST_ASSERT_EQUAL_UINT32(2, bins[0].count);
+  TEST_ASSERT_EQUAL_UINT8(20, bins[0].minKm);
+  TEST_ASSERT_EQUAL_UINT32(2, bins[1].count);
+
+  // nach 24 h ist alles draußen
+  agg.advance(m0 + 25 * 3600);
+  agg.series(60, 3, bins);
+  TEST_ASSERT_EQUAL_UINT32(0, bins[0].count + bins[1].count + bins[2].count);
+}
+
+// Volle History (8192 Einträge) über den Mock-WebServer ausgeben
+static void fillHistory() {
+  for (uint32_t i = 0; i < HISTORY_MAX; ++i) {
+    const TraceEntry& e = trace[i % trace.size()];
+    LightningEvent ev = {T0 + (time_t)i * 10, e.distance, e.energy, 8, true};
+    pipe->history.push_back(ev);
+  }
+}
+
+static void test_serialize_json() {
+  fillHistory();
+  WebServer srv;
+  EventQuery q; // alles
+  const size_t heapBefore = heapPeak = heapNow;
+  const Clock::time_point t = Clock::now();
+  EventJsonStream<EventStore<HISTORY_MAX>> s(pipe->history, q);
+  pump(srv, s);
+  const double us = usSince(t);
+  printf("[json] %u Ereignisse, %lu Bytes in %lu Chunks: %.1f ms → %.3f µs/Ereignis, Heap-Spitze +%lu B\n",
+         (unsigned)HISTORY_MAX, (unsigned long)srv.bytes, (unsigned long)srv.chunks, us / 1000,
+         us / HISTORY_MAX, (unsigned long)(heapPeak - heapBefore));
+  TEST_ASSERT_EQUAL(200, srv.code);
+  TEST_ASSERT_TRUE(srv.bytes > HISTORY_MAX * 60);
+
+  srv.reset();
+  srv.keepBody = true;
+  EventQuery page;
+  page.hasAfter = true;
+  page.afterSeq = pipe->history.headSeq() - 3;
+  EventJsonStream<EventStore<HISTORY_MAX>> s2(pipe->history, page);
+  pump(srv, s2);
+  TEST_ASSERT_EQUAL_STRING_LEN("{\"head_seq\":8192,\"events\":[{\"seq\":8190,", srv.body.c_str(), 39);
+}
+
+static void test_serialize_binary() {
+  fillHistory();
+  WebServer srv;
+  EventQuery q;
+  const size_t heapBefore = heapPeak = heapNow;
+  const Clock::time_point t = Clock::now();
+  EventBinaryStream<EventStore<HISTORY_MAX>> s(pipe->history, q);
+  pump(srv, s);
+  const double us = usSince(t);
+  printf("[bin]  %u Ereignisse, %lu Bytes in %lu Chunks: %.1f ms → %.3f µs/Ereignis, Heap-Spitze +%lu B\n",
+         (unsigned)HISTORY_MAX, (unsigned long)srv.bytes, (unsigned long)srv.chunks, us / 1000,
+         us / HISTORY_MAX, (unsigned long)(heapPeak - heapBefore));
+  TEST_ASSERT_EQUAL_UINT32(EVENT_BIN_HEADER_SIZE + HISTORY_MAX * sizeof(PackedEvent), srv.bytes);
+
+  srv.reset();
+  srv.keepBody = true;
+  EventBinaryStream<EventStore<HISTORY_MAX>> s2(pipe->history, q);
+  pump(srv, s2);
+  TEST_ASSERT_EQUAL_MEMORY("LTNG", srv.body.data(), 4);
+}
+
+static size_t countRows(const std::string& body) {
+  size_t n = 0;
+  for (size_t p = 0; (p = body.find("\"seq\":", p)) != std::string::npos; ++p) n++;
+  return n;
+}
+
+// Zeitbereich per binärer Suche, Wertefilter auf den gepackten Einträgen
+static void test_query_filters() {
+  pipe->history.restartAt(1);
+  fillHistory(); // seq 1..8192, ts = T0 + 10 * (seq - 1)
+  WebServer srv;
+  srv.keepBody = true;
+
+  EventQuery range; // 10 Einträge aus der Mitte, aufsteigend
+  range.cutoff = T0 + 1000;
+  range.until = T0 + 1090;
+  range.order = 1;
+  EventJsonStream<EventStore<HISTORY_MAX>> s(pipe->history, range);
+  pump(srv, s);
+  TEST_ASSERT_EQUAL_UINT32(10, countRows(srv.body));
+  TEST_ASSERT_TRUE(srv.body.find("\"events\":[{\"seq\":101,") != std::string::npos);
+
+  srv.reset();
+  EventQuery last; // neuester Eintrag bis until
+  last.until = T0 + 1095;
+  last.limit = 1;
+  EventJsonStream<EventStore<HISTORY_MAX>> s2(pipe->history, last);
+  pump(srv, s2);
+  TEST_ASSERT_TRUE(srv.body.find("\"events\":[{\"seq\":110,") != std::string::npos);
+  TEST_ASSERT_TRUE(srv.body.find("\"more\":true") != std::string::npos);
+
+  EventQuery f;
+  f.minKm = 5;
+  f.maxKm = 20;
+  f.minEnergy = 1000;
+  f.eventMask = 8;
+  uint32_t expected = 0;
+  for (size_t i = 0; i < pipe->history.size(); ++i) {
+    const LightningEvent e = pipe->history[i];
+    expected += e.distance >= 5 && e.distance <= 20 && e.energy >= 1000;
+  }
+  srv.reset();
+  const Clock::time_point t = Clock::now();
+  EventJsonStream<EventStore<HISTORY_MAX>> s3(pipe->history, f);
+  pump(srv, s3);
+  printf("[query] Filter über %u Einträge: %lu Treffer in %.1f ms\n", (unsigned)HISTORY_MAX,
+         (unsigned long)expected, usSince(t) / 1000);
+  TEST_ASSERT_EQUAL_UINT32(expected, countRows(srv.body));
+  f.eventMask = 4; // nur Störer: keine
+  srv.reset();
+  EventJsonStream<EventStore<HISTORY_MAX>> s4(pipe->history, f);
+  pump(srv, s4);
+  TEST_ASSERT_EQUAL_UINT32(0, countRows(srv.body));
+
+  // Binär: nur der Zeitbereich, lückenlos
+  srv.reset();
+  EventBinaryStream<EventStore<HISTORY_MAX>> b(pipe->history, range);
+  pump(srv, b);
+  TEST_ASSERT_EQUAL_UINT32(EVENT_BIN_HEADER_SIZE + 10 * sizeof(PackedEvent), srv.bytes);
+  TEST_ASSERT_EQUAL_UINT8(101, (uint8_t)srv.body[8]);
+}
+
+// Lücken in den Sequenznummern (Neustart hinter möglicherweise vergebenen Nummern): vorhandene
+// Einträge behalten ihre seq, after= springt über die Lücke, der Binärexport endet davor
+static void test_seq_gaps() {
+  EventStore<HISTORY_MAX>& h = pipe->history;
+  h.restartAt(11);
+  for (int i = 0; i < 3; ++i) h.push_back(LightningEvent{T0 + i, 10, 100, 8, true}); // seq 11..13
+  h.skipTo(5);   // rückwärts: ohne Wirkung
+  h.skipTo(142); // wie nach einem Neustart mit seq 13 im Log
+  TEST_ASSERT_EQUAL_UINT32(141, h.headSeq());
+  h.push_back(LightningEvent{T0 + 10, 9, 100, 8, true}); // seq 142
+  h.push_back(LightningEvent{T0 + 11, 8, 100, 8, true}); // seq 143
+  TEST_ASSERT_EQUAL_UINT32(143, h.headSeq());
+  TEST_ASSERT_EQUAL_UINT32(13, h.seqOf(h.beginPos() + 2));
+  TEST_ASSERT_EQUAL_UINT32(142, h.seqOf(h.beginPos() + 3));
+  TEST_ASSERT_EQUAL_UINT32(h.beginPos() + 3, h.posAfter(13));
+  TEST_ASSERT_EQUAL_UINT32(h.beginPos() + 3, h.posAfter(100));
+  TEST_ASSERT_EQUAL_UINT32(h.beginPos() + 4, h.posAfter(142));
+  TEST_ASSERT_EQUAL_UINT32(h.endPos(), h.posAfter(143));
+  TEST_ASSERT_EQUAL_UINT32(h.beginPos(), h.posAfter(0));
+
+  WebServer srv;
+  srv.keepBody = true;
+  EventQuery q;
+  q.hasAfter = true;
+  q.afterSeq = 12;
+  EventJsonStream<EventStore<HISTORY_MAX>> s(h, q);
+  pump(srv, s);
+  TEST_ASSERT_EQUAL_UINT32(3, countRows(srv.body));
+  TEST_ASSERT_TRUE(srv.body.find("{\"seq\":13,") != std::string::npos);
+  TEST_ASSERT_TRUE(srv.body.find("{\"seq\":142,") != std::string::npos);
+
+  srv.reset();
+  EventBinaryStream<EventStore<HISTORY_MAX>> b(h, q); // 13, dann Lücke
+  pump(srv, b);
+  TEST_ASSERT_EQUAL_UINT32(EVENT_BIN_HEADER_SIZE + sizeof(PackedEvent), srv.bytes);
+
+  // Fallen die Einträge vor der Lücke heraus, bleiben die Nummern danach gleich
+  for (int i = 0; i < 3; ++i) h.pop_front();
+  TEST_ASSERT_EQUAL_UINT32(142, h.seqOf(h.beginPos()));
+  TEST_ASSERT_EQUAL_UINT32(143, h.headSeq());
+  h.clear();
+  TEST_ASSERT_EQUAL_UINT32(143, h.headSeq());
+
+  // Mehr Lücken als die Tabelle fasst: die ältesten Einträge fallen heraus, keine Nummer ändert sich
+  for (uint32_t k = 0; k < 6; ++k) {
+    h.skipTo(h.headSeq() + 100);
+    h.push_back(LightningEvent{T0 + 20 + (time_t)k, 7, 100, 8, true});
+  }
+  TEST_ASSERT_TRUE(h.size() < 6);
+  TEST_ASSERT_EQUAL_UINT32(143 + 6 * 100, h.headSeq());
+  TEST_ASSERT_EQUAL_UINT32(143 + (7 - h.size()) * 100, h.seqOf(h.beginPos()));
+}
+
+// Vor der ersten Synchronisation: Blitze zurückhalten, Live-Werte ohne Zeit; danach mit
+// Unix-Zeit nachtragen. Nachlesungen und Störer gehen nie in die History.
+static void test_unsynced_and_live() {
+  TestHooks hooks;
+  RingBuffer<DistanceSample, 32> samples;
+  EventPipeline<HISTORY_MAX, 32, TestHooks> ev(pipe->history, pipe->stats, samples, hooks);
+  ev.handle(LightningEvent{12, 20, 500, 8, true}, EVENT_MASK, 12000);  // Blitz, Boot-Zeit
+  ev.handle(LightningEvent{13, 63, 0, 4, true}, EVENT_MASK, 13000);    // Störer
+  ev.handle(LightningEvent{14, 18, 700, 0, false}, EVENT_MASK, 14000); // Nachlesung
+  TEST_ASSERT_EQUAL_UINT32(0, hooks.records);
+  TEST_ASSERT_EQUAL_UINT32(1, samples.size());
+  LiveState l = ev.live();
+  TEST_ASSERT_FALSE(l.irq);
+  TEST_ASSERT_EQUAL_UINT8(18, l.distance);
+  TEST_ASSERT_TRUE(l.eventTs == 0);
+
+  hooks.bootOffset = T0;
+  TEST_ASSERT_EQUAL_UINT32(1, ev.flushUnsynced(T0));
+  TEST_ASSERT_TRUE(ev.synced());
+  TEST_ASSERT_EQUAL_UINT32(1, hooks.records);
+  TEST_ASSERT_TRUE(pipe->history.tsAt(0) == T0 + 12);
+  TEST_ASSERT_TRUE(samples[0].ts == T0 + 14);
+  TEST_ASSERT_TRUE(ev.live().eventTs == T0 + 12);
+
+  // danach: Boot-Zeitstempel aus der Queue werden beim Übernehmen umgerechnet
+  ev.handle(LightningEvent{15, 9, 900, 8, true}, EVENT_MASK, 15000);
+  TEST_ASSERT_EQUAL_UINT32(hooks.lastSeq, pipe->history.headSeq());
+  l = ev.live();
+  TEST_ASSERT_TRUE(l.irq);
+  TEST_ASSERT_EQUAL_UINT8(9, l.distance);
+  TEST_ASSERT_EQUAL_UINT32(900, l.energy);
+  TEST_ASSERT_TRUE(l.eventTs == T0 + 15);
+  TEST_ASSERT_EQUAL_UINT32(2, pipe->stats.query(3600).count());
+
+  ev.expireLive(20000, 10000); // noch nicht abgelaufen
+  TEST_ASSERT_EQUAL_UINT8(9, ev.live().distance);
+  ev.expireLive(25001, 10000);
+  l = ev.live();
+  TEST_ASSERT_EQUAL_UINT8(63, l.distance);
+  TEST_ASSERT_TRUE(l.eventTs == 0);
+}
+
+// Zerlegung gegen feste Registerinhalte nach Datenblatt (nicht gegen den Mock): Energie über
+// S_LIG_L/M/MM verteilt, die oberen Bits von 0x03, 0x06 und 0x07 gesetzt und ausgeblendet
+static void test_burst_decodes_register_layout() {
+  struct Vector {
+    uint8_t raw[AS3935_BURST_LEN]; // 0x03..0x07
+    uint8_t intSrc;
+    uint32_t energy;
+    uint8_t distance;
+  };
+  static const Vector vectors[] = {
+    // LCO_FDIV = 3, MASK_DIST gesetzt, INT_L; MM = 0xF5 → 0x15, 0x07 = 0xC7 → 7 km
+    {{0xE8, 0x5A, 0xC3, 0xF5, 0xC7}, 0x08, 0x15C35A, 7},
+    // INT_D, Energie 0, außer Reichweite
+    {{0x04, 0x00, 0x00, 0x00, 0x3F}, 0x04, 0, 63},
+    // INT_NH, alle Bits gesetzt: Energie auf 21 Bit, Distanz auf 6 Bit begrenzt
+    {{0xF1, 0xFF, 0xFF, 0xFF, 0xFF}, 0x01, 0x1FFFFF, 63},
+    // nur S_LIG_MM: Bit 20 bis 16
+    {{0x08, 0x00, 0x00, 0x10, 0x01}, 0x08, 0x100000, 1},
+  };
+  for (const Vector& v : vectors) {
+    const As3935Reading r = decodeAs3935Burst(v.raw);
+    TEST_ASSERT_EQUAL_UINT8(v.intSrc, r.intSrc);
+    TEST_ASSERT_EQUAL_UINT32(v.energy, r.energy);
+    TEST_ASSERT_EQUAL_UINT8(v.distance, r.distance);
+
+    // Nachlesung ab 0x04: dieselben Bytes ohne das Interruptregister
+    As3935Reading p = {};
+    decodeAs3935Measurement(v.raw + 1, p);
+    TEST_ASSERT_EQUAL_UINT32(v.energy, p.energy);
+    TEST_ASSERT_EQUAL_UINT8(v.distance, p.distance);
+  }
+}
+
+// Burst und Einzelaufrufe der Lib liefern dasselbe, mit einer statt fünf Transaktionen. Beide
+// Seiten kommen aus dem Mock; die Registerzuordnung prüft test_burst_decodes_register_layout.
+static void test_burst_matches_library() {
+  SparkFun_AS3935 lib, burst;
+  for (const TraceEntry& e : trace) {
+    lib.inject(e.intSrc, e.distance, e.energy & 0x1FFFFF);
+    burst.inject(e.intSrc, e.distance, e.energy & 0x1FFFFF);
+    const uint8_t intSrc = lib.readInterruptReg();
+    uint8_t buf[AS3935_BURST_LEN] = {};
+    burst.readRegisters(AS3935_REG_INT, buf, AS3935_BURST_LEN);
+    const As3935Reading r = decodeAs3935Burst(buf);
+    TEST_ASSERT_EQUAL_UINT8(intSrc, r.intSrc);
+    TEST_ASSERT_EQUAL_UINT8(lib.distanceToStorm(), r.distance);
+    TEST_ASSERT_EQUAL_UINT32(lib.lightningEnergy(), r.energy);
+  }
+  TEST_ASSERT_EQUAL_UINT32(5 * burst.i2cReads(), lib.i2cReads());
+
+  // Nachlesung ab 0x04 lässt das Interruptregister stehen
+  burst.inject(8, 17, 0x12345);
+  uint8_t poll[AS3935_POLL_LEN] = {};
+  burst.readRegisters(AS3935_REG_ENERGY, poll, AS3935_POLL_LEN);
+  As3935Reading r = {};
+  decodeAs3935Measurement(poll, r);
+  TEST_ASSERT_EQUAL_UINT8(17, r.distance);
+  TEST_ASSERT_EQUAL_UINT32(0x12345, r.energy);
+  TEST_ASSERT_EQUAL_UINT8(8, burst.readInterruptReg());
+}
+
+static void test_memory_footprint() {
+  printf("[mem]  History %lu B, Aggregate %lu B, Queue %lu B, Pipeline gesamt %lu B (statisch auf dem Gerät)\n",
+         (unsigned long)sizeof(pipe->history), (unsigned long)sizeof(pipe->stats),
+         (unsigned long)sizeof(pipe->queue), (unsigned long)sizeof(Pipeline));
+  TEST_ASSERT_TRUE(sizeof(pipe->history) <= HISTORY_MAX * sizeof(PackedEvent) + 64);
+}
+
+int main(int, char**) {
+  const char* path = getenv("LIGHTNING_TRACE");
+  if (!loadTrace(path ? path : "test/traces/storm_sample.csv")) synthTrace();
+  rotateToPeak();
+  traceSpanMs = trace.back().tMs;
+  printf("Trace: %lu Einträge über %.1f min\n", (unsigned long)trace.size(), traceSpanMs / 60000.0);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_stats_match_history);
+  RUN_TEST(test_series_bins);
+  RUN_TEST(test_replay_throughput);
+  RUN_TEST(test_replay_10x);
+  RUN_TEST(test_replay_100x);
+  RUN_TEST(test_replay_1000x);
+  RUN_TEST(test_serialize_json);
+  RUN_TEST(test_serialize_binary);
+  RUN_TEST(test_query_filters);
+  RUN_TEST(test_seq_gaps);
+  RUN_TEST(test_unsynced_and_live);
+  RUN_TEST(test_burst_decodes_register_layout);
+  RUN_TEST(test_burst_matches_library);
+  RUN_TEST(test_memory_footprint);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+// =============================
+// Host-Test des Gewitter-Trends (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "storm_trend.h"
+
+static constexpr time_t T0 = 1750000000;
+static StormTrend trend;
+static time_t clock_ = T0;
+
+void setUp() {
+  trend.clear();
+  clock_ = T0;
+}
+void tearDown() {}
+
+// Gleichmäßige Annäherung, ein Blitz alle 20 s; setzt die Zeit ab dem letzten Aufruf fort
+static time_t approach(float fromKm, float toKm, float kmh) {
+  time_t t = clock_;
+  for (float d = fromKm; d >= toKm; d -= kmh / 3600 * 20, t += 20) {
+    trend.update(t, (uint8_t)(d + 0.5f));
+  }
+  clock_ = t;
+  return t - 20;
+}
+
+static void test_rate() {
+  for (int i = 0; i < 200; ++i) trend.update(T0 + i * 6, 30); // 10 Blitze/min
+  TrendSnapshot s = trend.snapshot(T0 + 199 * 6);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 10.0f, s.ratePerMin);
+  // klingt ohne Blitze ab
+  s = trend.snapshot(T0 + 199 * 6 + 600);
+  TEST_ASSERT_TRUE(s.ratePerMin < 2.0f);
+}
+
+static void test_approach_speed_and_eta() {
+  const time_t t = approach(40, 20, 30);
+  const TrendSnapshot s = trend.snapshot(t);
+  TEST_ASSERT_TRUE(s.regression);
+  TEST_ASSERT_FLOAT_WITHIN(3.0f, 30.0f, s.approachKmh);
+  TEST_ASSERT_FLOAT_WITHIN(2.0f, 20.0f, s.distanceKm);
+  TEST_ASSERT_FLOAT_WITHIN(6.0f, 40.0f, s.etaMin); // 20 km bei 30 km/h
+}
+
+static void test_receding_has_no_eta() {
+  time_t t = T0;
+  for (int i = 0; i < 90; ++i, t += 20) trend.update(t, (uint8_t)(5 + i * 20 * 20 / 3600.0f + 0.5f));
+  const TrendSnapshot s = trend.snapshot(t - 20);
+  TEST_ASSERT_TRUE(s.approachKmh < -10);
+  TEST_ASSERT_EQUAL_FLOAT(-1.0f, s.etaMin);
+}
+
+static void test_levels_rise_immediately() {
+  approach(40, 30, 30);
+  TEST_ASSERT_EQUAL_UINT8(ALERT_WATCH, trend.level());
+  approach(30, 18, 30);
+  TEST_ASSERT_EQUAL_UINT8(ALERT_WARNING, trend.level());
+  trend.clear();
+  for (int i = 0; i < 5; ++i) trend.update(T0 + i * 30, 5);
+  TEST_ASSERT_EQUAL_UINT8(ALERT_DANGER, trend.level());
+}
+
+// Rauschen um die Schwelle darf die Stufe nicht flattern lassen
+static void test_hysteresis() {
+  time_t t = T0;
+  for (int i = 0; i < 40; ++i, t += 30) trend.update(t, 8);
+  TEST_ASSERT_EQUAL_UINT8(ALERT_DANGER, trend.level());
+  uint8_t minLevel = ALERT_DANGER;
+  for (int i = 0; i < 40; ++i, t += 30) {
+    trend.update(t, (i & 1) ? 10 : 12);
+    if (trend.level() < minLevel) minLevel = trend.level();
+  }
+  TEST_ASSERT_EQUAL_UINT8(ALERT_DANGER, minLevel);
+}
+
+static void test_quiet_resets() {
+  const time_t t = approach(25, 10, 30);
+  trend.advance(t + 60);
+  TEST_ASSERT_TRUE(trend.level() >= ALERT_WARNING);
+  trend.advance(t + StormTrend::QUIET_SEC);
+  TEST_ASSERT_EQUAL_UINT8(ALERT_NONE, trend.level());
+}
+
+static void test_out_of_range_only_counts_rate() {
+  for (int i = 0; i < 20; ++i) trend.update(T0 + i * 10, 63);
+  const TrendSnapshot s = trend.snapshot(T0 + 200);
+  TEST_ASSERT_TRUE(s.ratePerMin > 0);
+  TEST_ASSERT_EQUAL_FLOAT(-1.0f, s.distanceKm);
+  TEST_ASSERT_EQUAL_UINT8(ALERT_NONE, s.level);
+}
+
+// Vor der NTP-Synchronisation läuft der Trend auf Sekunden seit Boot, danach verschoben
+static void test_rebase_keeps_estimate() {
+  StormTrend boot;
+  time_t t = 5;
+  for (int i = 0; i < 60; ++i, t += 20) {
+    boot.update(t, (uint8_t)(30 - i * 20 * 30 / 3600.0f + 0.5f));
+    trend.update(T0 + t, (uint8_t)(30 - i * 20 * 30 / 3600.0f + 0.5f));
+  }
+  boot.rebase(T0);
+  const TrendSnapshot a = boot.snapshot(T0 + t);
+  const TrendSnapshot b = trend.snapshot(T0 + t);
+  TEST_ASSERT_EQUAL_UINT8(b.level, a.level);
+  TEST_ASSERT_EQUAL(b.lastTs, a.lastTs);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, b.distanceKm, a.distanceKm);
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, b.approachKmh, a.approachKmh);
+  TEST_ASSERT_FLOAT_WITHIN(0.1f, b.ratePerMin, a.ratePerMin);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_rate);
+  RUN_TEST(test_approach_speed_and_eta);
+  RUN_TEST(test_receding_has_no_eta);
+  RUN_TEST(test_levels_rise_immediately);
+  RUN_TEST(test_hysteresis);
+  RUN_TEST(test_quiet_resets);
+  RUN_TEST(test_out_of_range_only_counts_rate);
+  RUN_TEST(test_rebase_keeps_estimate);
+  return UNITY_END();
+}
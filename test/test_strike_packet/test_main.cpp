@@ -0,0 +1,97 @@
+// =============================
+// Host-Test Blitz-Datagramm und Nachbartabelle (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "strike_packet.h"
+
+static constexpr uint32_t WINDOW_MS = 20;
+static constexpr time_t T0 = 1750000000;
+
+void setUp() {}
+void tearDown() {}
+
+static LightningEvent strike(time_t ts, uint16_t ms, uint8_t km) {
+  LightningEvent e = {ts, km, 12345, 8, true, ms};
+  return e;
+}
+
+static void test_roundtrip() {
+  StrikeBatch b;
+  TEST_ASSERT_TRUE(b.add(strike(T0, 7, 12), 100, 0));
+  TEST_ASSERT_TRUE(b.add(strike(T0, 9, 11), 101, 3));
+  uint8_t buf[STRIKE_PKT_MAX];
+  const size_t n = b.encode(buf, 0xA1B2C3D4);
+  TEST_ASSERT_EQUAL_UINT32(STRIKE_PKT_HEADER_SIZE + 2 * STRIKE_PKT_ENTRY_SIZE, n);
+
+  StrikePacket pkt;
+  TEST_ASSERT_TRUE(decodeStrikePacket(buf, n, pkt));
+  TEST_ASSERT_EQUAL_UINT32(0xA1B2C3D4, pkt.nodeId);
+  TEST_ASSERT_EQUAL_UINT32(100, pkt.firstSeq);
+  TEST_ASSERT_EQUAL_UINT8(2, pkt.count);
+  const LightningEvent e = strikePacketEvent(pkt, 1);
+  TEST_ASSERT_TRUE(e.ts == T0);
+  TEST_ASSERT_EQUAL_UINT32(9, e.ms);
+  TEST_ASSERT_EQUAL_UINT8(11, e.distance);
+  TEST_ASSERT_EQUAL_UINT32(12345, e.energy);
+  TEST_ASSERT_EQUAL_UINT32(8, e.event);
+  TEST_ASSERT_TRUE(e.irq);
+
+  // falsche Länge oder Version → verworfen
+  TEST_ASSERT_FALSE(decodeStrikePacket(buf, n - 1, pkt));
+  buf[2] = 2;
+  TEST_ASSERT_FALSE(decodeStrikePacket(buf, n, pkt));
+}
+
+static void test_batch_window_and_gaps() {
+  StrikeBatch b;
+  TEST_ASSERT_FALSE(b.due(0, WINDOW_MS));
+  b.add(strike(T0, 0, 10), 5, 1000);
+  TEST_ASSERT_FALSE(b.due(1010, WINDOW_MS));
+  TEST_ASSERT_EQUAL_UINT32(10, b.remainingMs(1010, WINDOW_MS));
+  TEST_ASSERT_TRUE(b.due(1020, WINDOW_MS));
+  // Lücke in der seq → erst senden
+  TEST_ASSERT_FALSE(b.add(strike(T0, 1, 10), 7, 1005));
+  b.clear();
+  for (uint32_t i = 0; i < STRIKE_BATCH_MAX; ++i) TEST_ASSERT_TRUE(b.add(strike(T0, i, 10), 10 + i, 2000));
+  TEST_ASSERT_FALSE(b.add(strike(T0, 99, 10), 10 + STRIKE_BATCH_MAX, 2000));
+  TEST_ASSERT_TRUE(b.due(2000, WINDOW_MS)); // voll → sofort
+}
+
+static void test_peer_nearest() {
+  PeerTable<2> peers;
+  peers.add(1, 10, strike(T0, 0, 30));
+  peers.add(2, 50, strike(T0 + 60, 0, 8));
+  TEST_ASSERT_EQUAL_INT(8, peers.nearestKm(T0 + 100, 300));
+  TEST_ASSERT_EQUAL_INT(8, peers.nearestKm(T0 + 320, 300)); // Knoten 1 zu alt, Knoten 2 noch nicht
+  TEST_ASSERT_EQUAL_INT(-1, peers.nearestKm(T0 + 400, 300));
+  // Lücke zählen, Duplikat ignorieren
+  peers.add(1, 13, strike(T0 + 500, 0, 20));
+  peers.add(1, 13, strike(T0 + 510, 0, 5));
+  TEST_ASSERT_EQUAL_UINT32(2, peers[0].lost);
+  TEST_ASSERT_EQUAL_UINT32(2, peers[0].strikes);
+  TEST_ASSERT_EQUAL_INT(20, peers.nearestKm(T0 + 520, 300));
+  // voll: der Knoten mit dem ältesten Blitz wird ersetzt
+  peers.add(3, 1, strike(T0 + 600, 0, 3));
+  TEST_ASSERT_EQUAL_UINT32(2, peers.size());
+  TEST_ASSERT_EQUAL_UINT32(3, peers[1].nodeId);
+}
+
+// Boards desselben Herstellers unterscheiden sich nur in mac[3..5]
+static void test_node_id_from_mac() {
+  const uint8_t a[6] = {0x84, 0xF7, 0x03, 0x12, 0x34, 0x56};
+  const uint8_t b[6] = {0x84, 0xF7, 0x03, 0x12, 0x34, 0x57};
+  const uint8_t c[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56}; // andere OUI, gleiche Gerätebytes
+  TEST_ASSERT_EQUAL_UINT32(0x70123456, nodeIdFromMac(a));
+  TEST_ASSERT_TRUE(nodeIdFromMac(a) != nodeIdFromMac(b));
+  TEST_ASSERT_TRUE(nodeIdFromMac(a) != nodeIdFromMac(c));
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_roundtrip);
+  RUN_TEST(test_batch_window_and_gaps);
+  RUN_TEST(test_peer_nearest);
+  RUN_TEST(test_node_id_from_mac);
+  return UNITY_END();
+}
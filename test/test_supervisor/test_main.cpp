@@ -0,0 +1,63 @@
+// =============================
+// Host-Test Supervisor-Bausteine (pio test -e native)
+// =============================
+#include <unity.h>
+
+#include "supervisor.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_backoff_doubles_and_resets() {
+  RetryBackoff b(2000, 60000);
+  TEST_ASSERT_FALSE(b.take(0)); // nicht scharf
+  b.arm(1000);
+  b.arm(2500); // zweites DISCONNECTED verschiebt nichts
+  TEST_ASSERT_FALSE(b.take(2999));
+  TEST_ASSERT_TRUE(b.take(3000));
+  TEST_ASSERT_EQUAL_UINT32(4000, b.delayMs());
+  TEST_ASSERT_FALSE(b.take(6999));
+  TEST_ASSERT_TRUE(b.take(7000));
+  uint32_t t = 7000;
+  for (int i = 0; i < 10; ++i) {
+    t += b.delayMs();
+    TEST_ASSERT_TRUE(b.take(t));
+  }
+  TEST_ASSERT_EQUAL_UINT32(60000, b.delayMs());
+  TEST_ASSERT_EQUAL_UINT32(12, b.attempts());
+  b.reset();
+  TEST_ASSERT_FALSE(b.armed());
+  TEST_ASSERT_EQUAL_UINT32(2000, b.delayMs());
+}
+
+static void test_stall_detector() {
+  StallDetector s(20000);
+  TEST_ASSERT_FALSE(s.update(5, 0));
+  TEST_ASSERT_FALSE(s.update(6, 15000));
+  TEST_ASSERT_FALSE(s.update(6, 34999));
+  TEST_ASSERT_TRUE(s.update(6, 35000));
+  TEST_ASSERT_FALSE(s.update(7, 36000)); // läuft wieder
+  StallDetector w(1000);
+  w.update(1, UINT32_MAX - 100);
+  TEST_ASSERT_FALSE(w.update(1, 800));
+  TEST_ASSERT_TRUE(w.update(1, 900));
+}
+
+static void test_failure_streak() {
+  FailureStreak f(3);
+  TEST_ASSERT_FALSE(f.report(false));
+  TEST_ASSERT_FALSE(f.report(false));
+  TEST_ASSERT_FALSE(f.report(true)); // Ausreißer vorbei
+  TEST_ASSERT_FALSE(f.report(false));
+  TEST_ASSERT_FALSE(f.report(false));
+  TEST_ASSERT_TRUE(f.report(false));
+  TEST_ASSERT_EQUAL_UINT32(0, f.streak());
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_backoff_doubles_and_resets);
+  RUN_TEST(test_stall_detector);
+  RUN_TEST(test_failure_streak);
+  return UNITY_END();
+}